@@ -0,0 +1,226 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sched.h>
+#include <stdlib.h>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace xcl {
+
+// Kept samples of a benchmark and their statistics, times in s
+struct BenchmarkStats {
+    std::vector<double> samples; // in the order they were taken
+    size_t outliers = 0;         // samples rejected as outliers
+    double min = 0;
+    double median = 0;
+    double max = 0;
+    double mean = 0;
+    double stddev = 0;
+    double ci = 0;          // half width of the 95% confidence interval of the mean
+    bool converged = false; // the interval tightened before the limits
+
+    double relative_ci() const { return mean > 0 ? ci / mean : 0; }
+};
+
+// Runs a measurement until its result can be trusted: a few warmup runs to
+// fault in pages, pin buffers and fill caches and TLBs, then repetitions
+// until the 95% confidence interval of the mean is within target_ci of the
+// mean, or the repetition or time limit is reached. Samples whose modified
+// z-score (their distance to the median in median absolute deviations,
+// scaled by 0.6745) exceeds 3.5 are rejected as outliers before the
+// statistics are computed.
+//
+// The defaults can be changed without rebuilding through XCL_BENCH_WARMUP,
+// XCL_BENCH_MIN_REPS, XCL_BENCH_MAX_REPS, XCL_BENCH_CI (relative, e.g. 0.02)
+// and XCL_BENCH_MAX_TIME (s). XCL_BENCH_CPU=<n> pins the calling thread to
+// CPU n and switches its frequency governor to performance when permitted,
+// the previous governor is put back when the process exits. Values that are
+// not non-negative numbers are ignored with a warning. Emulation runs once
+// without warmup.
+class Benchmark {
+   public:
+    unsigned warmup = 1;
+    unsigned min_reps = 3;
+    unsigned max_reps = 20;
+    double target_ci = 0.02;
+    double max_seconds = 2;
+    int cpu = -1;
+
+    Benchmark() {
+        if (getenv("XCL_EMULATION_MODE")) {
+            warmup = 0;
+            min_reps = 1;
+            max_reps = 1;
+        }
+        env("XCL_BENCH_WARMUP", warmup);
+        env("XCL_BENCH_MIN_REPS", min_reps);
+        env("XCL_BENCH_MAX_REPS", max_reps);
+        env("XCL_BENCH_CI", target_ci);
+        env("XCL_BENCH_MAX_TIME", max_seconds);
+        env("XCL_BENCH_CPU", cpu);
+        min_reps = std::max(min_reps, 1u);
+        max_reps = std::max(max_reps, min_reps);
+        if (cpu >= 0) pin(cpu);
+    }
+
+    // Prints the settings once, so logs tell how the numbers were taken
+    void describe() const {
+        std::cout << "Benchmark: " << warmup << " warmup, " << min_reps << " to " << max_reps
+                  << " runs until the 95% confidence interval is within " << target_ci * 100 << "%, CPU "
+                  << (cpu >= 0 ? std::to_string(cpu) : std::string("not pinned")) << std::endl;
+    }
+
+    // Times fn(), which does one repetition of the measured work
+    template <typename F>
+    BenchmarkStats run(F fn) {
+        return measure([&] {
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        });
+    }
+
+    // Collects the samples returned by fn(), for measurements timed by the
+    // device, such as profiling events or kernel cycle counters
+    template <typename F>
+    BenchmarkStats measure(F fn) {
+        for (unsigned i = 0; i < warmup; i++) fn();
+
+        std::vector<double> samples;
+        BenchmarkStats stats;
+        auto start = std::chrono::steady_clock::now();
+        while (samples.size() < max_reps) {
+            samples.push_back(fn());
+            if (samples.size() < min_reps) continue;
+            stats = statistics(samples);
+            if (stats.samples.size() >= min_reps && stats.relative_ci() <= target_ci) {
+                stats.converged = true;
+                break;
+            }
+            if (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > max_seconds) break;
+        }
+        return stats;
+    }
+
+    // Pins the calling thread to a CPU and asks for its highest frequency.
+    // Changing the governor needs root, otherwise the current one is kept
+    // and a warning tells that frequency scaling may affect the timings. A
+    // changed governor is restored at exit.
+    static void pin(int cpu) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            std::cout << "WARNING: Failed to pin the benchmark thread to CPU " << cpu << std::endl;
+            return;
+        }
+        std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cpufreq/scaling_governor";
+        std::string governor;
+        std::ifstream(path) >> governor;
+        if (governor.empty() || governor == "performance") return;
+        std::ofstream(path) << "performance";
+        std::string now;
+        std::ifstream(path) >> now;
+        if (now == "performance")
+            governors().saved.insert(std::make_pair(path, governor));
+        else
+            std::cout << "WARNING: CPU " << cpu << " runs the " << governor
+                      << " frequency governor, timings may vary with its clock" << std::endl;
+    }
+
+   private:
+    // Governors changed by pin(), written back when the process exits
+    struct GovernorRestore {
+        std::map<std::string, std::string> saved; // sysfs path, governor
+        ~GovernorRestore() {
+            for (auto& g : saved) std::ofstream(g.first) << g.second;
+        }
+    };
+
+    static GovernorRestore& governors() {
+        static GovernorRestore restore;
+        return restore;
+    }
+
+    template <typename T>
+    static void env(const char* name, T& value) {
+        const char* s = getenv(name);
+        if (!s || !*s) return;
+        char* end = nullptr;
+        double v = strtod(s, &end);
+        bool whole = !std::is_integral<T>::value || v == std::floor(v);
+        if (*end != '\0' || !(v >= 0) || v > (double)std::numeric_limits<T>::max() || !whole) {
+            std::cout << "WARNING: Ignoring " << name << "=" << s << ", expected a non-negative "
+                      << (std::is_integral<T>::value ? "integer" : "number") << std::endl;
+            return;
+        }
+        value = (T)v;
+    }
+
+    static double median_of(std::vector<double> v) {
+        std::sort(v.begin(), v.end());
+        size_t n = v.size();
+        return (n % 2) ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+    }
+
+    // Two sided 95% quantile of Student's t distribution
+    static double t95(size_t dof) {
+        static const double t[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                   2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                   2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+        if (dof == 0) return 0;
+        return dof <= 30 ? t[dof - 1] : 1.960;
+    }
+
+    static BenchmarkStats statistics(const std::vector<double>& samples) {
+        BenchmarkStats stats;
+        // Modified z-score of Iglewicz and Hoaglin
+        double median = median_of(samples);
+        std::vector<double> deviations;
+        for (auto s : samples) deviations.push_back(std::fabs(s - median));
+        double mad = median_of(deviations);
+        for (auto s : samples) {
+            if (mad > 0 && 0.6745 * std::fabs(s - median) / mad > 3.5)
+                stats.outliers++;
+            else
+                stats.samples.push_back(s);
+        }
+
+        size_t n = stats.samples.size();
+        stats.min = *std::min_element(stats.samples.begin(), stats.samples.end());
+        stats.max = *std::max_element(stats.samples.begin(), stats.samples.end());
+        stats.median = median_of(stats.samples);
+        for (auto s : stats.samples) stats.mean += s;
+        stats.mean /= n;
+        double var = 0;
+        for (auto s : stats.samples) var += (s - stats.mean) * (s - stats.mean);
+        stats.stddev = (n > 1) ? std::sqrt(var / (n - 1)) : 0;
+        stats.ci = t95(n - 1) * stats.stddev / std::sqrt((double)n);
+        return stats;
+    }
+};
+}
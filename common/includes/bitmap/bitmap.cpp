@@ -14,14 +14,123 @@
 * under the License.
 */
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <cstring>
 #include <iostream>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BITMAP_X86_SIMD 1
+#endif
 
 #include "bitmap.h"
 
+// Pixels are kept as one int each, holding the file's B, G and R bytes in
+// its low 24 bits. The unpack/pack kernels below convert whole rows between
+// that layout and packed RGB24. The SIMD variants are selected at runtime
+// so the default -O0 host build still gets them.
+
+static void unpack_rgb24_scalar(const unsigned char* src, int* dst, int count) {
+    for (int i = 0; i < count; ++i) {
+        dst[i] = src[3 * i] | (src[3 * i + 1] << 8) | (src[3 * i + 2] << 16);
+    }
+}
+
+static void pack_rgb24_scalar(const int* src, unsigned char* dst, int count) {
+    for (int i = 0; i < count; ++i) {
+        dst[3 * i] = src[i] & 0xff;
+        dst[3 * i + 1] = (src[i] >> 8) & 0xff;
+        dst[3 * i + 2] = (src[i] >> 16) & 0xff;
+    }
+}
+
+#ifdef BITMAP_X86_SIMD
+// 4 pixels (12 bytes) <-> 4 ints, per 128 bit lane
+#define UNPACK_MASK 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1
+#define PACK_MASK 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1
+
+// The loads read 4 bytes past the 12 they use, so the vector loops stop
+// early enough to stay inside the row and the scalar code does the tail.
+__attribute__((target("ssse3"))) static void unpack_rgb24_ssse3(const unsigned char* src, int* dst, int count) {
+    const __m128i mask = _mm_setr_epi8(UNPACK_MASK);
+    int i = 0;
+    for (; i + 6 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + 3 * i));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_shuffle_epi8(v, mask));
+    }
+    unpack_rgb24_scalar(src + 3 * i, dst + i, count - i);
+}
+
+__attribute__((target("avx2"))) static void unpack_rgb24_avx2(const unsigned char* src, int* dst, int count) {
+    const __m256i mask = _mm256_setr_epi8(UNPACK_MASK, UNPACK_MASK);
+    int i = 0;
+    for (; i + 10 <= count; i += 8) {
+        __m128i lo = _mm_loadu_si128((const __m128i*)(src + 3 * i));
+        __m128i hi = _mm_loadu_si128((const __m128i*)(src + 3 * i + 12));
+        __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_shuffle_epi8(v, mask));
+    }
+    unpack_rgb24_ssse3(src + 3 * i, dst + i, count - i);
+}
+
+// Likewise the stores write 4 bytes past the 12 they produce, which the
+// next iteration or the scalar tail overwrites.
+__attribute__((target("ssse3"))) static void pack_rgb24_ssse3(const int* src, unsigned char* dst, int count) {
+    const __m128i mask = _mm_setr_epi8(PACK_MASK);
+    int i = 0;
+    for (; i + 6 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dst + 3 * i), _mm_shuffle_epi8(v, mask));
+    }
+    pack_rgb24_scalar(src + i, dst + 3 * i, count - i);
+}
+
+__attribute__((target("avx2"))) static void pack_rgb24_avx2(const int* src, unsigned char* dst, int count) {
+    const __m256i mask = _mm256_setr_epi8(PACK_MASK, PACK_MASK);
+    int i = 0;
+    for (; i + 10 <= count; i += 8) {
+        __m256i v = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(src + i)), mask);
+        _mm_storeu_si128((__m128i*)(dst + 3 * i), _mm256_castsi256_si128(v));
+        _mm_storeu_si128((__m128i*)(dst + 3 * i + 12), _mm256_extracti128_si256(v, 1));
+    }
+    pack_rgb24_ssse3(src + i, dst + 3 * i, count - i);
+}
+#endif
+
+typedef void (*unpack_fn)(const unsigned char*, int*, int);
+typedef void (*pack_fn)(const int*, unsigned char*, int);
+
+static unpack_fn select_unpack() {
+#ifdef BITMAP_X86_SIMD
+    if (__builtin_cpu_supports("avx2")) return unpack_rgb24_avx2;
+    if (__builtin_cpu_supports("ssse3")) return unpack_rgb24_ssse3;
+#endif
+    return unpack_rgb24_scalar;
+}
+
+static pack_fn select_pack() {
+#ifdef BITMAP_X86_SIMD
+    if (__builtin_cpu_supports("avx2")) return pack_rgb24_avx2;
+    if (__builtin_cpu_supports("ssse3")) return pack_rgb24_ssse3;
+#endif
+    return pack_rgb24_scalar;
+}
+
+static bool write_all(int fd, const char* buf, size_t size) {
+    while (size > 0) {
+        ssize_t n = write(fd, buf, size);
+        if (n <= 0) return false;
+        buf += n;
+        size -= n;
+    }
+    return true;
+}
+
 BitmapInterface::BitmapInterface(const char* f) : filename(f) {
     core = nullptr;
     dib = nullptr;
@@ -36,6 +145,7 @@ BitmapInterface::BitmapInterface(const char* f) : filename(f) {
 
     height = -1;
     width = -1;
+    rowStride = 0;
 }
 
 BitmapInterface::~BitmapInterface() {
@@ -47,62 +157,105 @@ BitmapInterface::~BitmapInterface() {
 bool BitmapInterface::readBitmapFile() {
     // First, open the bitmap file
     int fd;
-    unsigned int fileSize;
+    struct stat st;
 
     fd = open(filename, O_RDONLY);
-    if (fd < 0) {
+    if (fd < 0 || fstat(fd, &st) != 0) {
         std::cerr << "Cannot read image file " << filename << std::endl;
+        if (fd >= 0) close(fd);
         return false;
     }
+    size_t length = st.st_size;
 
-    core = new char[14];
-    read(fd, core, 14);
-    magicNumber = (*(unsigned short*)(&(core[0])));
-    fileSize = (*(unsigned int*)(&(core[2])));
-    offsetOfImage = (*(unsigned int*)(&(core[10])));
+    // Map the whole file, or read it in one go where it cannot be mapped
+    const unsigned char* file = nullptr;
+    std::vector<unsigned char> contents;
+    void* mapped = length > 0 ? mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    if (mapped != MAP_FAILED) {
+        madvise(mapped, length, MADV_SEQUENTIAL);
+        file = (const unsigned char*)mapped;
+    } else {
+        contents.resize(length);
+        size_t done = 0;
+        while (done < length) {
+            ssize_t n = read(fd, &contents[done], length - done);
+            if (n <= 0) break;
+            done += n;
+        }
+        contents.resize(done);
+        length = done;
+        file = contents.data();
+    }
+    close(fd);
 
-    // Just read in the DIB, but don't process it
-    sizeOfDIB = offsetOfImage - 14;
-    dib = new char[sizeOfDIB];
-    read(fd, dib, sizeOfDIB);
+    bool valid = false;
+    if (length >= 14 + 16) {
+        magicNumber = (*(unsigned short*)(&(file[0])));
+        fileSize = (*(unsigned int*)(&(file[2])));
+        offsetOfImage = (*(unsigned int*)(&(file[10])));
 
-    width = (*(int*)(&(dib[4])));
-    height = (*(int*)(&(dib[8])));
+        // Keep the DIB for writing, only the dimensions are processed
+        sizeOfDIB = offsetOfImage - 14;
+        if (magicNumber == 0x4d42 && offsetOfImage >= 14 + 16 && offsetOfImage <= length) {
+            width = (*(int*)(&(file[14 + 4])));
+            height = (*(int*)(&(file[14 + 8])));
+            unsigned short bitsPerPixel = (*(unsigned short*)(&(file[14 + 14])));
 
-    sizeOfImage = fileSize - 14 - sizeOfDIB;
-    int numPixels = sizeOfImage / 3; // RGB
+            rowStride = (width * 3 + 3) & ~3;
+            sizeOfImage = rowStride * abs(height);
+            valid = bitsPerPixel == 24 && width > 0 && (size_t)offsetOfImage + sizeOfImage <= length;
+        }
+    }
 
-    image = new int[numPixels];
+    if (valid) {
+        core = new char[14];
+        memcpy(core, file, 14);
+        dib = new char[sizeOfDIB];
+        memcpy(dib, file + 14, sizeOfDIB);
 
-    for (int i = 0; i < numPixels; ++i) {
         // Use an integer for every pixel even though we might not need that
         //  much space (padding 0 bits in the rest of the integer)
-        image[i] = 0;
-        read(fd, &(image[i]), 3);
+        image = new int[numPixels()];
+        unpack_fn unpack = select_unpack();
+        for (int row = 0; row < abs(height); ++row) {
+            unpack(file + offsetOfImage + (size_t)row * rowStride, image + (size_t)row * width, width);
+        }
+    } else {
+        std::cerr << "Unsupported or truncated image file " << filename << ", expected a 24 bit bitmap" << std::endl;
     }
 
-    return true;
+    if (mapped != MAP_FAILED) munmap(mapped, st.st_size);
+    return valid;
 }
 
 bool BitmapInterface::writeBitmapFile(int* otherImage) {
     int fd;
-    fd = open("output.bmp", O_WRONLY | O_CREAT, 0644);
+    fd = open("output.bmp", O_WRONLY | O_CREAT | O_TRUNC, 0644);
 
     if (fd < 0) {
         std::cerr << "Cannot open output.bmp for writing!" << std::endl;
         return false;
     }
 
-    write(fd, core, 14);
-    write(fd, dib, sizeOfDIB);
-
-    int numPixels = sizeOfImage / 3;
-
     int* outputImage = otherImage != nullptr ? otherImage : image;
 
-    for (int i = 0; i < numPixels; ++i) {
-        write(fd, &(outputImage[i]), 3);
+    // Build the whole file in memory, rows zero padded to the stride, and
+    // write it with as few calls as possible.
+    std::vector<char> buf(14 + sizeOfDIB + sizeOfImage, 0);
+    memcpy(&buf[0], core, 14);
+    memcpy(&buf[14], dib, sizeOfDIB);
+    unsigned char* pixels = (unsigned char*)&buf[14 + sizeOfDIB];
+    pack_fn pack = select_pack();
+    for (int row = 0; row < abs(height); ++row) {
+        unsigned char* dst = pixels + (size_t)row * rowStride;
+        pack(outputImage + (size_t)row * width, dst, width);
+        memset(dst + width * 3, 0, rowStride - width * 3);
     }
 
-    return true;
+    bool ok = write_all(fd, buf.data(), buf.size());
+    close(fd);
+    if (!ok) {
+        std::cerr << "Failed to write output.bmp!" << std::endl;
+    }
+    return ok;
 }
@@ -36,6 +36,9 @@ class BitmapInterface {
     int height;
     int width;
 
+    // Bytes per row in the file, rows are padded to a multiple of 4
+    int rowStride;
+
    public:
     BitmapInterface(const char* f);
     ~BitmapInterface();
@@ -44,7 +47,7 @@ class BitmapInterface {
     bool writeBitmapFile(int* otherImage = nullptr);
 
     inline int* bitmap() { return image; }
-    unsigned int numPixels() { return sizeOfImage / 3; }
+    unsigned int numPixels() { return width < 0 ? 0 : width * abs(height); }
 
     inline int getHeight() { return height; }
     inline int getWidth() { return width; }
@@ -0,0 +1,210 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+#pragma once
+
+#include "xcl2.hpp"
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace xcl {
+
+// Identifies a bucket of interchangeable device buffers. The size is kept
+// exact so that migrations of a pooled buffer move the requested byte count.
+struct BufferKey {
+    size_t size;
+    int bank;
+    uint64_t flags;
+
+    bool operator<(const BufferKey& o) const {
+        if (size != o.size) return size < o.size;
+        if (bank != o.bank) return bank < o.bank;
+        return flags < o.flags;
+    }
+};
+
+// Reusable pool of device buffers. Buffers are handed out as leases and come
+// back to their bucket when the lease is destroyed, so a steady-state loop
+// requesting the same (size, bank, flags) combinations allocates nothing.
+//
+// The Allocator provides the runtime specific part:
+//   typedef ... buffer_type;
+//   buffer_type create(size_t size, int bank, uint64_t flags);
+//   void warm(buffer_type& buf, size_t size, uint64_t flags);
+template <typename Allocator>
+class BufferPool {
+   public:
+    typedef typename Allocator::buffer_type buffer_type;
+
+    class Lease {
+       public:
+        Lease() : m_pool(nullptr) {}
+        Lease(BufferPool* pool, const BufferKey& key, const buffer_type& buf) : m_pool(pool), m_key(key), m_buf(buf) {}
+        Lease(Lease&& o) : m_pool(o.m_pool), m_key(o.m_key), m_buf(std::move(o.m_buf)) { o.m_pool = nullptr; }
+        Lease& operator=(Lease&& o) {
+            if (this != &o) {
+                release();
+                m_pool = o.m_pool;
+                m_key = o.m_key;
+                m_buf = std::move(o.m_buf);
+                o.m_pool = nullptr;
+            }
+            return *this;
+        }
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease() { release(); }
+
+        buffer_type& get() { return m_buf; }
+        buffer_type& operator*() { return m_buf; }
+        buffer_type* operator->() { return &m_buf; }
+        size_t size() const { return m_key.size; }
+
+        // Returns the buffer to the pool before the lease goes out of scope
+        void release() {
+            if (m_pool != nullptr) {
+                m_pool->give_back(m_key, m_buf);
+                m_pool = nullptr;
+            }
+        }
+
+       private:
+        BufferPool* m_pool;
+        BufferKey m_key;
+        buffer_type m_buf;
+    };
+
+    explicit BufferPool(const Allocator& allocator, size_t max_cached_bytes = ~size_t(0))
+        : m_allocator(allocator), m_max_cached_bytes(max_cached_bytes), m_cached_bytes(0), m_created(0) {}
+
+    Lease lease(size_t size, int bank = -1, uint64_t flags = 0) {
+        BufferKey key = {size, bank, flags};
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_free.find(key);
+            if (it != m_free.end() && !it->second.empty()) {
+                buffer_type buf = it->second.back();
+                it->second.pop_back();
+                m_cached_bytes -= size;
+                return Lease(this, key, buf);
+            }
+            m_created++;
+        }
+        return Lease(this, key, m_allocator.create(size, bank, flags));
+    }
+
+    // Creates count buffers of the given kind up front and lets the
+    // allocator touch them, so that the first lease does not pay for the
+    // device allocation or host pinning.
+    void prewarm(size_t size, int bank, uint64_t flags, size_t count) {
+        BufferKey key = {size, bank, flags};
+        std::vector<buffer_type> bufs;
+        for (size_t i = 0; i < count; i++) {
+            bufs.push_back(m_allocator.create(size, bank, flags));
+            m_allocator.warm(bufs.back(), size, flags);
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_created += count;
+        for (auto& b : bufs) {
+            m_free[key].push_back(b);
+            m_cached_bytes += size;
+        }
+    }
+
+    // Releases every buffer currently cached in the pool
+    void clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free.clear();
+        m_cached_bytes = 0;
+    }
+
+    size_t cached_bytes() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_cached_bytes;
+    }
+
+    // Number of buffers the pool had to create since construction
+    size_t created() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_created;
+    }
+
+   private:
+    void give_back(const BufferKey& key, const buffer_type& buf) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free[key].push_back(buf);
+        m_cached_bytes += key.size;
+        // Over budget: drop idle buffers of other buckets first
+        for (auto it = m_free.begin(); it != m_free.end() && m_cached_bytes > m_max_cached_bytes; ++it) {
+            if (it->first.size == key.size && it->first.bank == key.bank && it->first.flags == key.flags) continue;
+            while (!it->second.empty() && m_cached_bytes > m_max_cached_bytes) {
+                it->second.pop_back();
+                m_cached_bytes -= it->first.size;
+            }
+        }
+        std::vector<buffer_type>& own = m_free[key];
+        while (!own.empty() && m_cached_bytes > m_max_cached_bytes) {
+            own.pop_back();
+            m_cached_bytes -= key.size;
+        }
+    }
+
+    Allocator m_allocator;
+    mutable std::mutex m_mutex;
+    std::map<BufferKey, std::vector<buffer_type> > m_free;
+    size_t m_max_cached_bytes;
+    size_t m_cached_bytes;
+    size_t m_created;
+};
+
+// OpenCL allocator, bank >= 0 places the buffer in that memory topology index.
+// flags are cl_mem_flags and must not request a host pointer.
+class ClBufferAllocator {
+   public:
+    typedef cl::Buffer buffer_type;
+
+    ClBufferAllocator(const cl::Context& context, const cl::CommandQueue& queue) : m_context(context), m_queue(queue) {}
+
+    cl::Buffer create(size_t size, int bank, uint64_t flags) {
+        cl_int err;
+        cl::Buffer buf;
+        if (bank >= 0) {
+            cl_mem_ext_ptr_t ext;
+            ext.flags = bank | XCL_MEM_TOPOLOGY;
+            ext.obj = nullptr;
+            ext.param = 0;
+            OCL_CHECK(err, buf = cl::Buffer(m_context, (cl_mem_flags)flags | CL_MEM_EXT_PTR_XILINX, size, &ext, &err));
+        } else {
+            OCL_CHECK(err, buf = cl::Buffer(m_context, (cl_mem_flags)flags, size, nullptr, &err));
+        }
+        return buf;
+    }
+
+    // Forces the runtime to back the buffer on the device
+    void warm(cl::Buffer& buf, size_t size, uint64_t flags) {
+        cl_int err;
+        OCL_CHECK(err, err = m_queue.enqueueMigrateMemObjects({buf}, CL_MIGRATE_MEM_OBJECT_CONTENT_UNDEFINED));
+        OCL_CHECK(err, err = m_queue.finish());
+    }
+
+   private:
+    cl::Context m_context;
+    cl::CommandQueue m_queue;
+};
+
+typedef BufferPool<ClBufferAllocator> ClBufferPool;
+}
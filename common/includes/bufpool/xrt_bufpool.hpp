@@ -0,0 +1,55 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+#pragma once
+
+#include "bufpool.hpp"
+#include <cstring>
+
+// XRT includes
+#include "experimental/xrt_bo.h"
+#include "experimental/xrt_device.h"
+
+namespace xcl {
+
+// XRT allocator, bank is the kernel argument group_id and flags is the
+// numeric value of xrt::bo::flags.
+class XrtBoAllocator {
+   public:
+    typedef xrt::bo buffer_type;
+
+    explicit XrtBoAllocator(const xrt::device& device) : m_device(device) {}
+
+    xrt::bo create(size_t size, int bank, uint64_t flags) {
+        return xrt::bo(m_device, size, static_cast<xrt::bo::flags>(flags), bank);
+    }
+
+    // Faults in and pins the host backing, and places normal buffers on the
+    // device once
+    void warm(xrt::bo& bo, size_t size, uint64_t flags) {
+        xrt::bo::flags f = static_cast<xrt::bo::flags>(flags);
+        if (f == xrt::bo::flags::device_only) return;
+        auto map = bo.map<char*>();
+        std::memset(map, 0, size);
+        if (f == xrt::bo::flags::normal) bo.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+    }
+
+   private:
+    xrt::device m_device;
+};
+
+typedef BufferPool<XrtBoAllocator> XrtBoPool;
+}
@@ -44,6 +44,112 @@ bool starts_with(const string& src, const string& sub) {
     return (src.find(sub) == 0);
 }
 
+bool parse_size(const std::string& s, uint64_t& value) {
+    std::string str = s;
+    trim(str);
+    size_t digits = 0;
+    while (digits < str.length() && std::isdigit(str[digits])) digits++;
+    if (digits == 0) return false;
+
+    std::string suffix = ToUpper(str.substr(digits));
+    if (suffix.length() > 1 && suffix[suffix.length() - 1] == 'B') suffix.erase(suffix.length() - 1);
+    uint64_t scale = 1;
+    if (suffix == "K")
+        scale = 1ULL << 10;
+    else if (suffix == "M")
+        scale = 1ULL << 20;
+    else if (suffix == "G")
+        scale = 1ULL << 30;
+    else if (suffix == "T")
+        scale = 1ULL << 40;
+    else if (!suffix.empty())
+        return false;
+
+    value = strtoull(str.substr(0, digits).c_str(), nullptr, 10) * scale;
+    return true;
+}
+
+bool parse_sweep(const std::string& s, std::vector<uint64_t>& values) {
+    values.clear();
+    size_t start = 0;
+    while (start <= s.length()) {
+        size_t comma = s.find(',', start);
+        if (comma == std::string::npos) comma = s.length();
+        std::string item = s.substr(start, comma - start);
+        start = comma + 1;
+
+        size_t dots = item.find("..");
+        if (dots == std::string::npos) {
+            uint64_t v;
+            if (!parse_size(item, v)) return false;
+            values.push_back(v);
+            continue;
+        }
+
+        // range, with an optional ":x<factor>" or ":+<step>"
+        std::string last = item.substr(dots + 2);
+        std::string step = "+1";
+        size_t colon = last.find(':');
+        if (colon != std::string::npos) {
+            step = last.substr(colon + 1);
+            last = last.substr(0, colon);
+        }
+        uint64_t first_v, last_v, step_v;
+        if (!parse_size(item.substr(0, dots), first_v) || !parse_size(last, last_v)) return false;
+        if (step.length() < 2 || (step[0] != 'x' && step[0] != 'X' && step[0] != '+')) return false;
+        if (!parse_size(step.substr(1), step_v)) return false;
+        bool geometric = (step[0] != '+');
+        if ((geometric && (step_v < 2 || first_v == 0)) || (!geometric && step_v == 0)) return false;
+
+        for (uint64_t v = first_v; v <= last_v;) {
+            values.push_back(v);
+            uint64_t next = geometric ? v * step_v : v + step_v;
+            if (next <= v) break; // overflow
+            v = next;
+        }
+    }
+    return !values.empty();
+}
+
+void SweepSpace::add(const std::string& name, const std::vector<uint64_t>& values) {
+    m_names.push_back(name);
+    m_values.push_back(values);
+}
+
+size_t SweepSpace::size() const {
+    if (m_values.empty()) return 0;
+    size_t n = 1;
+    for (size_t i = 0; i < m_values.size(); i++) n *= m_values[i].size();
+    return n;
+}
+
+SweepSpace::Point SweepSpace::point(size_t index) const {
+    std::vector<uint64_t> values(m_values.size());
+    for (size_t d = m_values.size(); d-- > 0;) {
+        size_t n = m_values[d].size();
+        values[d] = m_values[d][index % n];
+        index /= n;
+    }
+    return Point(this, values);
+}
+
+uint64_t SweepSpace::Point::operator[](const std::string& name) const {
+    for (size_t d = 0; d < m_space->dims(); d++) {
+        if (m_space->name(d) == name) return m_values[d];
+    }
+    LogWarn("The sweep dimension %s is not recognized!", name.c_str());
+    return 0;
+}
+
+std::string SweepSpace::Point::to_string() const {
+    std::string result;
+    for (size_t d = 0; d < m_values.size(); d++) {
+        if (d > 0) result += " ";
+        result += m_space->name(d) + "=" + std::to_string(m_values[d]);
+    }
+    return result;
+}
+
 CmdLineParser::CmdLineParser() {
     // TODO Auto-generated constructor stub
     m_strDefaultKey = "";
@@ -300,6 +406,36 @@ double CmdLineParser::value_to_double(const char* key) {
     return atof(strVal.c_str());
 }
 
+uint64_t CmdLineParser::value_to_size(const char* key) {
+    string strVal = value(key);
+    uint64_t result = 0;
+    if (strVal.length() == 0 || !parse_size(strVal, result)) {
+        LogError("Invalid size %s passed to %s", strVal.c_str(), key);
+        return 0;
+    }
+    return result;
+}
+
+std::vector<uint64_t> CmdLineParser::value_to_list(const char* key) {
+    string strVal = value(key);
+    std::vector<uint64_t> result;
+    if (strVal.length() == 0 || !parse_sweep(strVal, result)) {
+        LogError("Invalid list or range %s passed to %s", strVal.c_str(), key);
+        result.clear();
+    }
+    return result;
+}
+
+SweepSpace CmdLineParser::sweep(const std::vector<std::string>& keys) {
+    SweepSpace space;
+    for (size_t i = 0; i < keys.size(); i++) {
+        string name = keys[i];
+        while (starts_with(name, "-")) name.erase(0, 1);
+        space.add(name, value_to_list(keys[i].c_str()));
+    }
+    return space;
+}
+
 bool CmdLineParser::isValid(const char* key) {
     string strKey(key);
     if (!starts_with(strKey, "--")) strKey = "--" + strKey;
@@ -313,6 +449,8 @@ bool CmdLineParser::isValid(const char* key) {
 }
 
 void CmdLineParser::printHelp() {
+    // keep queued log records ahead of the help text
+    LogFlush();
     printf("===========================================================\n");
     string strAllShortcuts = "";
     for (size_t i = 0; i < m_vSwitches.size(); i++) {
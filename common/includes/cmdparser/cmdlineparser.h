@@ -17,6 +17,7 @@
 #define CMDLINEPARSER_H_
 
 #include <map>
+#include <stdint.h>
 #include <string>
 #include <vector>
 
@@ -25,6 +26,73 @@ namespace utils {
 
 bool is_file(const std::string& name);
 
+/*!
+ * Parses a size with an optional binary suffix K, M, G or T (case
+ * insensitive, optionally followed by B), e.g. "4K" is 4096.
+ */
+bool parse_size(const std::string& s, uint64_t& value);
+
+/*!
+ * Parses a sweep specification: a comma separated list whose items are
+ * either a size or a range "<first>..<last>[:x<factor>|:+<step>]".
+ * Ranges step by +1 unless told otherwise and include <last> when it is
+ * reached, e.g. "4K..256M:x2", "1,2,4,8" or "1..4,16".
+ */
+bool parse_sweep(const std::string& s, std::vector<uint64_t>& values);
+
+/*!
+ * Cartesian product of named value lists. Iteration visits the dimensions
+ * like nested loops in the order they were added, the last one varying
+ * fastest.
+ */
+class SweepSpace {
+   public:
+    class Point {
+       public:
+        Point(const SweepSpace* space, const std::vector<uint64_t>& values) : m_space(space), m_values(values) {}
+
+        uint64_t operator[](const std::string& name) const;
+        uint64_t at(size_t dim) const { return m_values[dim]; }
+        // "name=value name=value ..."
+        std::string to_string() const;
+
+       private:
+        const SweepSpace* m_space;
+        std::vector<uint64_t> m_values;
+    };
+
+    class iterator {
+       public:
+        iterator(const SweepSpace* space, size_t index) : m_space(space), m_index(index) {}
+
+        Point operator*() const { return m_space->point(m_index); }
+        iterator& operator++() {
+            m_index++;
+            return *this;
+        }
+        bool operator==(const iterator& o) const { return m_index == o.m_index; }
+        bool operator!=(const iterator& o) const { return m_index != o.m_index; }
+
+       private:
+        const SweepSpace* m_space;
+        size_t m_index;
+    };
+
+    void add(const std::string& name, const std::vector<uint64_t>& values);
+    size_t dims() const { return m_names.size(); }
+    const std::string& name(size_t dim) const { return m_names[dim]; }
+    // number of points, 0 if any dimension is empty
+    size_t size() const;
+    Point point(size_t index) const;
+
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, size()); }
+
+   private:
+    std::vector<std::string> m_names;
+    std::vector<std::vector<uint64_t> > m_values;
+};
+
 /*!
  * Synopsis:
  * 1.Parses the command line passed in from the user and stores all enabled
@@ -78,6 +146,23 @@ class CmdLineParser {
 
     double value_to_double(const char* key);
 
+    /*!
+     * retrieve a size such as "64K" or "16M", returns 0 if invalid
+     */
+    uint64_t value_to_size(const char* key);
+
+    /*!
+     * retrieve a list or range such as "1,2,4,8" or "4K..256M:x2",
+     * returns an empty list if invalid
+     */
+    std::vector<uint64_t> value_to_list(const char* key);
+
+    /*!
+     * cartesian product of the lists given to the keys, named after the
+     * keys without their leading dashes
+     */
+    SweepSpace sweep(const std::vector<std::string>& keys);
+
     /*!
      * Returns true if a valid value is supplied by user
      */
@@ -0,0 +1,116 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace xcl {
+
+// Histogram of non-negative integer samples, typically latencies in ns, in
+// the style of HdrHistogram: every power of two range is split into the
+// same number of linear sub-buckets, so any value is kept with a relative
+// error below 2^-(sub_bits - 1) while the whole 64-bit range fits into a
+// few thousand counters. Recording is constant time and allocation free.
+class Histogram {
+   public:
+    explicit Histogram(unsigned sub_bits = 8)
+        : m_sub_bits(sub_bits),
+          m_half(1ull << (sub_bits - 1)),
+          m_counts((65 - sub_bits) * m_half + m_half, 0),
+          m_count(0),
+          m_min(UINT64_MAX),
+          m_max(0),
+          m_sum(0) {}
+
+    void record(uint64_t value, uint64_t times = 1) {
+        m_counts[index(value)] += times;
+        m_count += times;
+        m_sum += (double)value * times;
+        if (value < m_min) m_min = value;
+        if (value > m_max) m_max = value;
+    }
+
+    // Adds the samples of another histogram with the same sub_bits
+    void merge(const Histogram& o) {
+        for (size_t i = 0; i < m_counts.size() && i < o.m_counts.size(); i++) m_counts[i] += o.m_counts[i];
+        m_count += o.m_count;
+        m_sum += o.m_sum;
+        if (o.m_min < m_min) m_min = o.m_min;
+        if (o.m_max > m_max) m_max = o.m_max;
+    }
+
+    void reset() {
+        std::fill(m_counts.begin(), m_counts.end(), 0);
+        m_count = 0;
+        m_min = UINT64_MAX;
+        m_max = 0;
+        m_sum = 0;
+    }
+
+    uint64_t count() const { return m_count; }
+    uint64_t min() const { return m_count ? m_min : 0; }
+    uint64_t max() const { return m_max; }
+    double mean() const { return m_count ? m_sum / m_count : 0; }
+
+    // Smallest value that at least p percent of the samples are below or
+    // equal to, up to the bucket resolution. p = 100 gives the max.
+    uint64_t percentile(double p) const {
+        if (m_count == 0) return 0;
+        uint64_t rank = (uint64_t)(p / 100 * m_count + 0.5);
+        if (rank < 1) rank = 1;
+        if (rank >= m_count) return m_max;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < m_counts.size(); i++) {
+            seen += m_counts[i];
+            if (seen >= rank) {
+                uint64_t high = highest(i);
+                return high < m_max ? high : m_max;
+            }
+        }
+        return m_max;
+    }
+
+   private:
+    // Values below 2 * half are counted exactly. Above, the value is
+    // shifted so that half <= (value >> shift) < 2 * half and the bucket is
+    // shift * half + (value >> shift).
+    size_t index(uint64_t value) const {
+        if (value < 2 * m_half) return value;
+        unsigned shift = 63 - __builtin_clzll(value) - (m_sub_bits - 1);
+        return shift * m_half + (value >> shift);
+    }
+
+    // Largest value counted in bucket i
+    uint64_t highest(size_t i) const {
+        if (i < 2 * m_half) return i;
+        unsigned shift = i / m_half - 1;
+        uint64_t sub = i - shift * m_half;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    unsigned m_sub_bits;
+    uint64_t m_half;
+    std::vector<uint64_t> m_counts;
+    uint64_t m_count;
+    uint64_t m_min;
+    uint64_t m_max;
+    double m_sum;
+};
+}
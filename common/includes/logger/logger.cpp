@@ -15,13 +15,23 @@
 */
 #include "logger.h"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <fstream>
 #include <functional>
+#include <mutex>
 #include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
 #include <time.h>
+#include <unordered_map>
 #ifdef WINDOWS
 #include <direct.h>
+#include <process.h>
 #else
+#include <sys/syscall.h>
 #include <unistd.h>
 #endif
 
@@ -61,7 +71,25 @@ string ToUpper(const string& s) {
 }
 
 string GetTimeStamp() {
-    return "";
+    auto now = std::chrono::system_clock::now();
+    time_t rawtime = std::chrono::system_clock::to_time_t(now);
+    long usec = (long)(std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count() % 1000000);
+    struct tm timeinfo;
+#ifdef WINDOWS
+    localtime_s(&timeinfo, &rawtime);
+#else
+    localtime_r(&rawtime, &timeinfo);
+#endif
+    char date[32];
+    char buffer[48];
+    strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &timeinfo);
+    snprintf(buffer, sizeof(buffer), "%s.%06ld", date, usec);
+    return string(buffer);
+}
+
+uint64_t GetMonotonicNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
 }
 
 // trim from start
@@ -98,82 +126,521 @@ string GetFileTitleOnly(const string& s) {
     return temp;
 }
 
-void LogWrapper(int etype, const char* file, int line, const char* desc, ...) {
-    // crop file name from full path
-    string strFileLoc(file);
-    strFileLoc = strFileLoc.substr(strFileLoc.find_last_of("\\/") + 1);
-
-    string strHeader = "";
-    {
-        char header[512];
-        // source
-        switch (etype) {
-            case (sda::etError): {
-                snprintf(header, sizeof(header), "ERROR: [%s:%d]", strFileLoc.c_str(), line);
-                break;
+namespace {
+
+const size_t kLogRecordSize = 1152;
+const size_t kLogRingSlots = 256;
+
+struct LogRecord {
+    size_t len;
+    char text[kLogRecordSize];
+};
+
+// Single producer (the owning thread), single consumer (the writer thread)
+struct LogRing {
+    std::atomic<size_t> head;
+    std::atomic<size_t> tail;
+    std::atomic<bool> orphaned;
+    LogRecord slots[kLogRingSlots];
+};
+
+void WriteRecords(const char* text, size_t len, FILE*& file) {
+    fwrite(text, 1, len, stdout);
+    fflush(stdout);
+#ifdef ENABLE_LOG_TOFILE
+    if (file == nullptr) file = fopen("benchapp.log", "a");
+    if (file != nullptr) {
+        fwrite(text, 1, len, file);
+        fflush(file);
+    }
+#endif
+}
+
+class AsyncLogBackend {
+   public:
+    static AsyncLogBackend* instance() {
+        // intentionally leaked, records may still be logged from static destructors
+        static AsyncLogBackend* backend = new AsyncLogBackend();
+        return backend;
+    }
+
+    bool running() const { return !m_stop.load(std::memory_order_acquire); }
+
+    // returns the slot to format into, the record is published by commit().
+    // Returns nullptr when the ring is full and the backend has stopped, as
+    // nothing drains it any more, the caller then writes the record itself.
+    LogRecord* reserve(LogRing*& ring) {
+        ring = thread_ring();
+        size_t t = ring->tail.load(std::memory_order_relaxed);
+        while (t - ring->head.load(std::memory_order_acquire) >= kLogRingSlots) {
+            if (!running()) return nullptr;
+            wake();
+            std::this_thread::yield();
+        }
+        return &ring->slots[t % kLogRingSlots];
+    }
+
+    void commit(LogRing* ring) {
+        ring->tail.store(ring->tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        if (m_sleeping.load(std::memory_order_acquire)) wake();
+    }
+
+    void flush() {
+        while (running() && !empty()) {
+            wake();
+            std::this_thread::yield();
+        }
+    }
+
+    void shutdown() {
+        if (m_stop.exchange(true)) return;
+        wake();
+        if (m_thread.joinable()) m_thread.join();
+        drain();
+        if (m_file != nullptr) {
+            fclose(m_file);
+            m_file = nullptr;
+        }
+    }
+
+    // used once the writer has stopped
+    void write_sync(const char* text, size_t len) {
+        std::lock_guard<std::mutex> lock(m_rings_mutex);
+        FILE* file = nullptr;
+        WriteRecords(text, len, file);
+        if (file != nullptr) fclose(file);
+    }
+
+   private:
+    struct RingHolder {
+        LogRing* ring;
+        RingHolder() : ring(nullptr) {}
+        ~RingHolder() {
+            if (ring != nullptr) ring->orphaned.store(true, std::memory_order_release);
+        }
+    };
+
+    AsyncLogBackend() : m_file(nullptr) {
+        m_stop.store(false);
+        m_sleeping.store(false);
+        m_thread = std::thread(&AsyncLogBackend::run, this);
+        atexit([]() { AsyncLogBackend::instance()->shutdown(); });
+    }
+
+    LogRing* thread_ring() {
+        static thread_local RingHolder holder;
+        if (holder.ring == nullptr) {
+            std::lock_guard<std::mutex> lock(m_rings_mutex);
+            // reuse the ring of a thread that has exited once it is drained
+            for (auto r : m_rings) {
+                if (r->orphaned.load(std::memory_order_acquire) &&
+                    r->head.load(std::memory_order_acquire) == r->tail.load(std::memory_order_acquire)) {
+                    r->orphaned.store(false, std::memory_order_release);
+                    holder.ring = r;
+                    break;
+                }
             }
-            case (sda::etInfo): {
-                snprintf(header, sizeof(header), "INFO: [%s:%d]", strFileLoc.c_str(), line);
-                break;
+            if (holder.ring == nullptr) {
+                LogRing* r = new LogRing();
+                r->head.store(0);
+                r->tail.store(0);
+                r->orphaned.store(false);
+                m_rings.push_back(r);
+                holder.ring = r;
             }
-            case (sda::etWarning): {
-                snprintf(header, sizeof(header), "WARN: [%s:%d]", strFileLoc.c_str(), line);
-                break;
+        }
+        return holder.ring;
+    }
+
+    bool empty() {
+        std::lock_guard<std::mutex> lock(m_rings_mutex);
+        for (auto r : m_rings) {
+            if (r->head.load(std::memory_order_acquire) != r->tail.load(std::memory_order_acquire)) return false;
+        }
+        return true;
+    }
+
+    void wake() {
+        std::lock_guard<std::mutex> lock(m_wake_mutex);
+        m_wake.notify_one();
+    }
+
+    // writes everything currently queued as one batch, returns record count
+    size_t drain() {
+        std::lock_guard<std::mutex> lock(m_rings_mutex);
+        size_t count = 0;
+        m_batch.clear();
+        std::vector<std::pair<LogRing*, size_t> > done;
+        for (auto r : m_rings) {
+            size_t h = r->head.load(std::memory_order_relaxed);
+            size_t t = r->tail.load(std::memory_order_acquire);
+            for (; h != t; h++, count++) {
+                const LogRecord& rec = r->slots[h % kLogRingSlots];
+                m_batch.append(rec.text, rec.len);
             }
+            done.push_back(std::make_pair(r, t));
         }
-        strHeader = string(header);
+        if (!m_batch.empty()) WriteRecords(m_batch.data(), m_batch.size(), m_file);
+        // release the slots only once their text has been written
+        for (auto& d : done) d.first->head.store(d.second, std::memory_order_release);
+        return count;
     }
 
-    // time
-    string strTime = "";
+    void run() {
+        while (running()) {
+            if (drain() > 0) continue;
+            std::unique_lock<std::mutex> lock(m_wake_mutex);
+            m_sleeping.store(true, std::memory_order_release);
+            m_wake.wait_for(lock, std::chrono::milliseconds(5));
+            m_sleeping.store(false, std::memory_order_release);
+        }
+    }
+
+    std::mutex m_rings_mutex;
+    std::vector<LogRing*> m_rings;
+    std::mutex m_wake_mutex;
+    std::condition_variable m_wake;
+    std::atomic<bool> m_sleeping;
+    std::atomic<bool> m_stop;
+    std::thread m_thread;
+    std::string m_batch;
+    FILE* m_file;
+};
+
+// formats "<header> <time> <message>\n" into out, returns the length
+size_t FormatRecord(char* out, size_t cap, int etype, const char* file, int line, const char* desc, va_list args) {
+    // crop file name from full path
+    const char* fileLoc = strrchr(file, '/');
+    const char* fileLocWin = strrchr(file, '\\');
+    if (fileLocWin > fileLoc) fileLoc = fileLocWin;
+    fileLoc = (fileLoc == nullptr) ? file : fileLoc + 1;
+
+    const char* tag = "INFO";
+    switch (etype) {
+        case (sda::etError):
+            tag = "ERROR";
+            break;
+        case (sda::etWarning):
+            tag = "WARN";
+            break;
+        default:
+            break;
+    }
+
+    const char* strTime = "";
 #ifdef ENABLE_LOG_TIME
-    {
-        time_t rawtime;
-        time(&rawtime);
-#ifdef ENABLE_SECURE_API
-        char buffer[64];
+    // wall clock to the microsecond, as GetTimeStamp(), the date part is
+    // only reformatted when the second changes
+    static thread_local time_t lastTime = 0;
+    static thread_local char dateBuf[32] = "";
+    char timeBuf[64];
+    auto now = std::chrono::system_clock::now();
+    time_t rawtime = std::chrono::system_clock::to_time_t(now);
+    long usec = (long)(std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count() % 1000000);
+    if (rawtime != lastTime) {
         struct tm timeinfo;
+#ifdef WINDOWS
         localtime_s(&timeinfo, &rawtime);
-        asctime_s(timeinfo, buffer, sizeof(buffer)) snprintf(buffer, sizeof(buffer), "TIME: [%s]", asctime(timeinfo));
-        strTime = string(buffer);
 #else
-        char buffer[64];
-        struct tm* timeinfo = localtime(&rawtime);
-        string temp = string(asctime(timeinfo));
-        temp = trim(temp);
-
-        //        strftime(buffer, sizeof(buffer), "TIME: []")
-        snprintf(buffer, sizeof(buffer), "TIME: [%s]", temp.c_str());
-        strTime = string(buffer);
+        localtime_r(&rawtime, &timeinfo);
 #endif
+        strftime(dateBuf, sizeof(dateBuf), "%Y-%m-%d %H:%M:%S", &timeinfo);
+        lastTime = rawtime;
     }
+    snprintf(timeBuf, sizeof(timeBuf), "TIME: [%s.%06ld]", dateBuf, usec);
+    strTime = timeBuf;
 #endif
 
-    // format the message itself
-    string strMsg = "";
-    {
-        char msg[512];
-        va_list args;
-        va_start(args, desc);
-        vsnprintf(msg, sizeof(msg), desc, args);
+    int n = snprintf(out, cap, "%s: [%s:%d] %s ", tag, fileLoc, line, strTime);
+    if (n < 0) n = 0;
+    size_t len = std::min<size_t>(n, cap - 1);
+
+    // format the message itself, limited to 512 characters as before
+    size_t msgCap = std::min<size_t>(512, cap - len - 1);
+    int m = vsnprintf(out + len, msgCap, desc, args);
+    if (m > 0) len += std::min<size_t>(m, msgCap - 1);
+
+    out[len++] = '\n';
+    return len;
+}
+
+} // namespace
+
+void LogWrapper(int etype, const char* file, int line, const char* desc, ...) {
+    va_list args;
+    va_start(args, desc);
+#ifdef ENABLE_LOG_ASYNC
+    AsyncLogBackend* backend = AsyncLogBackend::instance();
+    LogRing* ring = nullptr;
+    LogRecord* rec = backend->running() ? backend->reserve(ring) : nullptr;
+    if (rec != nullptr) {
+        rec->len = FormatRecord(rec->text, sizeof(rec->text), etype, file, line, desc, args);
         va_end(args);
-        strMsg = string(msg);
+        backend->commit(ring);
+        // errors are on the console before the caller goes on to report the
+        // failure they caused
+        if (etype == sda::etError) backend->flush();
+        return;
     }
+    char text[kLogRecordSize];
+    size_t len = FormatRecord(text, sizeof(text), etype, file, line, desc, args);
+    va_end(args);
+    backend->write_sync(text, len);
+#else
+    char text[kLogRecordSize];
+    size_t len = FormatRecord(text, sizeof(text), etype, file, line, desc, args);
+    va_end(args);
+    FILE* logFile = nullptr;
+    WriteRecords(text, len, logFile);
+    if (logFile != nullptr) fclose(logFile);
+#endif
+}
 
-    // combine
-    string strOut = strHeader + string(" ") + strTime + string(" ") + strMsg + string("\n");
+void LogFlush() {
+#ifdef ENABLE_LOG_ASYNC
+    AsyncLogBackend::instance()->flush();
+#endif
+}
 
-    // display
-    cout << strOut;
+namespace {
 
-// store
-#ifdef ENABLE_LOG_TOFILE
-    std::ofstream outfile;
-    outfile.open("benchapp.log", std::ios_base::app);
-    outfile << strOut;
+struct TraceRecord {
+    uint64_t ts;
+    uint32_t name;
+    uint16_t thread;
+    uint8_t phase;
+    uint8_t reserved;
+};
+
+struct TraceThread {
+    std::mutex mutex;
+    std::vector<TraceRecord> records;
+    std::unordered_map<const char*, uint32_t> names;
+    uint16_t index;
+};
+
+struct TraceState {
+    std::atomic<bool> enabled;
+    std::mutex mutex;
+    std::vector<string> names;
+    std::unordered_map<string, uint32_t> nameIds;
+    std::vector<TraceThread*> threads;
+    std::vector<uint64_t> osThreadIds;
+    string exitFile;
+};
+
+TraceState& GetTraceState() {
+    // intentionally leaked, events may be recorded from static destructors
+    static TraceState* state = new TraceState();
+    return *state;
+}
+
+uint64_t GetOsThreadId() {
+#ifdef WINDOWS
+    return (uint64_t)std::hash<std::thread::id>()(std::this_thread::get_id());
+#else
+    return (uint64_t)syscall(SYS_gettid);
 #endif
+}
+
+TraceThread* GetTraceThread() {
+    static thread_local TraceThread* thread = nullptr;
+    if (thread == nullptr) {
+        TraceState& state = GetTraceState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        thread = new TraceThread();
+        thread->index = (uint16_t)state.threads.size();
+        thread->records.reserve(4096);
+        state.threads.push_back(thread);
+        state.osThreadIds.push_back(GetOsThreadId());
+    }
+    return thread;
+}
+
+uint32_t InternTraceName(TraceThread* thread, const char* name) {
+    auto it = thread->names.find(name);
+    if (it != thread->names.end()) return it->second;
+    TraceState& state = GetTraceState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    string key(name);
+    auto id = state.nameIds.find(key);
+    uint32_t result;
+    if (id == state.nameIds.end()) {
+        result = (uint32_t)state.names.size();
+        state.names.push_back(key);
+        state.nameIds[key] = result;
+    } else {
+        result = id->second;
+    }
+    thread->names[name] = result;
+    return result;
+}
+
+struct TraceSnapshot {
+    std::vector<string> names;
+    std::vector<uint64_t> osThreadIds;
+    std::vector<TraceRecord> records;
+};
+
+void TakeTraceSnapshot(TraceSnapshot& snap) {
+    TraceState& state = GetTraceState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    snap.names = state.names;
+    snap.osThreadIds = state.osThreadIds;
+    for (auto t : state.threads) {
+        std::lock_guard<std::mutex> tlock(t->mutex);
+        snap.records.insert(snap.records.end(), t->records.begin(), t->records.end());
+    }
+    std::stable_sort(snap.records.begin(), snap.records.end(),
+                     [](const TraceRecord& a, const TraceRecord& b) { return a.ts < b.ts; });
+}
+
+const char kTraceMagic[8] = {'S', 'D', 'A', 'T', 'R', 'C', '1', '\0'};
+
+bool LoadTraceSnapshot(const char* filename, TraceSnapshot& snap) {
+    FILE* fp = fopen(filename, "rb");
+    if (fp == nullptr) return false;
+    char magic[8];
+    uint32_t numNames = 0, numThreads = 0;
+    uint64_t numRecords = 0;
+    bool ok = fread(magic, sizeof(magic), 1, fp) == 1 && memcmp(magic, kTraceMagic, sizeof(magic)) == 0 &&
+              fread(&numNames, sizeof(numNames), 1, fp) == 1 && fread(&numThreads, sizeof(numThreads), 1, fp) == 1 &&
+              fread(&numRecords, sizeof(numRecords), 1, fp) == 1;
+    for (uint32_t i = 0; ok && i < numNames; i++) {
+        uint32_t len = 0;
+        ok = fread(&len, sizeof(len), 1, fp) == 1;
+        string name(len, '\0');
+        if (ok && len > 0) ok = fread(&name[0], len, 1, fp) == 1;
+        snap.names.push_back(name);
+    }
+    if (ok) {
+        snap.osThreadIds.resize(numThreads);
+        snap.records.resize(numRecords);
+        if (numThreads > 0) ok = fread(snap.osThreadIds.data(), sizeof(uint64_t), numThreads, fp) == numThreads;
+        if (ok && numRecords > 0) ok = fread(snap.records.data(), sizeof(TraceRecord), numRecords, fp) == numRecords;
+    }
+    fclose(fp);
+    return ok;
+}
+
+void WriteJsonString(FILE* fp, const string& s) {
+    fputc('"', fp);
+    for (char c : s) {
+        if (c == '"' || c == '\\')
+            fprintf(fp, "\\%c", c);
+        else if ((unsigned char)c < 0x20)
+            fprintf(fp, "\\u%04x", c);
+        else
+            fputc(c, fp);
+    }
+    fputc('"', fp);
+}
+
+void ExportTraceAtExit() {
+    TraceState& state = GetTraceState();
+    if (!state.exitFile.empty()) TraceExportChrome(state.exitFile.c_str());
+}
+
+struct TraceAutoStart {
+    TraceAutoStart() {
+        const char* file = getenv("SDA_TRACE");
+        if (file != nullptr && strlen(file) > 0) {
+            GetTraceState().exitFile = file;
+            TraceEnable(true);
+            atexit(ExportTraceAtExit);
+        }
+    }
+} g_traceAutoStart;
+
+} // namespace
+
+void TraceEnable(bool enable) {
+    GetTraceState().enabled.store(enable, std::memory_order_release);
+}
+
+bool TraceEnabled() {
+    return GetTraceState().enabled.load(std::memory_order_relaxed);
+}
 
-    return;
+void TraceEvent(int phase, const char* name) {
+    if (!TraceEnabled()) return;
+    uint64_t ts = GetMonotonicNs();
+    TraceThread* thread = GetTraceThread();
+    TraceRecord rec;
+    rec.ts = ts;
+    rec.name = InternTraceName(thread, name);
+    rec.thread = thread->index;
+    rec.phase = (uint8_t)phase;
+    rec.reserved = 0;
+    std::lock_guard<std::mutex> lock(thread->mutex);
+    thread->records.push_back(rec);
+}
+
+bool TraceSave(const char* filename) {
+    TraceSnapshot snap;
+    TakeTraceSnapshot(snap);
+    FILE* fp = fopen(filename, "wb");
+    if (fp == nullptr) {
+        LogError("Cannot open trace file %s", filename);
+        return false;
+    }
+    uint32_t numNames = (uint32_t)snap.names.size();
+    uint32_t numThreads = (uint32_t)snap.osThreadIds.size();
+    uint64_t numRecords = snap.records.size();
+    fwrite(kTraceMagic, sizeof(kTraceMagic), 1, fp);
+    fwrite(&numNames, sizeof(numNames), 1, fp);
+    fwrite(&numThreads, sizeof(numThreads), 1, fp);
+    fwrite(&numRecords, sizeof(numRecords), 1, fp);
+    for (auto& name : snap.names) {
+        uint32_t len = (uint32_t)name.size();
+        fwrite(&len, sizeof(len), 1, fp);
+        fwrite(name.data(), 1, len, fp);
+    }
+    fwrite(snap.osThreadIds.data(), sizeof(uint64_t), numThreads, fp);
+    fwrite(snap.records.data(), sizeof(TraceRecord), numRecords, fp);
+    bool ok = !ferror(fp);
+    fclose(fp);
+    return ok;
+}
+
+bool TraceExportChrome(const char* json_filename, const char* binary_filename) {
+    TraceSnapshot snap;
+    if (binary_filename != nullptr) {
+        if (!LoadTraceSnapshot(binary_filename, snap)) {
+            LogError("Cannot read trace file %s", binary_filename);
+            return false;
+        }
+    } else {
+        TakeTraceSnapshot(snap);
+    }
+
+    FILE* fp = fopen(json_filename, "w");
+    if (fp == nullptr) {
+        LogError("Cannot open trace file %s", json_filename);
+        return false;
+    }
+#ifdef WINDOWS
+    int pid = _getpid();
+#else
+    int pid = getpid();
+#endif
+    static const char* phases[] = {"B", "E", "i"};
+    uint64_t origin = snap.records.empty() ? 0 : snap.records.front().ts;
+    fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for (size_t i = 0; i < snap.records.size(); i++) {
+        const TraceRecord& r = snap.records[i];
+        uint64_t rel = r.ts - origin;
+        uint64_t tid = (r.thread < snap.osThreadIds.size()) ? snap.osThreadIds[r.thread] : r.thread;
+        fprintf(fp, "%s\n{\"name\":", (i == 0) ? "" : ",");
+        WriteJsonString(fp, (r.name < snap.names.size()) ? snap.names[r.name] : string("?"));
+        fprintf(fp, ",\"cat\":\"host\",\"ph\":\"%s\",\"ts\":%llu.%03llu,\"pid\":%d,\"tid\":%llu%s}",
+                phases[r.phase < 3 ? r.phase : 2], (unsigned long long)(rel / 1000), (unsigned long long)(rel % 1000),
+                pid, (unsigned long long)tid, (r.phase == etTraceInstant) ? ",\"s\":\"t\"" : "");
+    }
+    fprintf(fp, "\n]}\n");
+    bool ok = !ferror(fp);
+    fclose(fp);
+    return ok;
 }
 
 } // namespace sda
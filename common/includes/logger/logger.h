@@ -18,23 +18,37 @@
 
 #include <iomanip>
 #include <iostream>
+#include <stdint.h>
 #include <string>
 #include <vector>
 
 #define ENABLE_LOG_TOFILE 1
 #define ENABLE_LOG_TIME 1
+// Records are formatted by the caller and written by a background thread,
+// LogError() waits until its record and all before it are written
+#define ENABLE_LOG_ASYNC 1
 
 // global logging
 #define LogInfo(desc, ...) sda::LogWrapper(0, __FILE__, __LINE__, desc, ##__VA_ARGS__)
 #define LogWarn(desc, ...) sda::LogWrapper(1, __FILE__, __LINE__, desc, ##__VA_ARGS__)
 #define LogError(desc, ...) sda::LogWrapper(2, __FILE__, __LINE__, desc, ##__VA_ARGS__)
 
+// tracing, name must be a string with static storage duration
+#define TraceBegin(name) sda::TraceEvent(sda::etTraceBegin, name)
+#define TraceEnd(name) sda::TraceEvent(sda::etTraceEnd, name)
+#define TraceInstant(name) sda::TraceEvent(sda::etTraceInstant, name)
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TraceScope(name) sda::TraceSpan TRACE_CONCAT(trace_span_, __LINE__)(name)
+
 using namespace std;
 
 namespace sda {
 
 enum LOGTYPE { etInfo, etWarning, etError };
 
+enum TRACEPHASE { etTraceBegin, etTraceEnd, etTraceInstant };
+
 // string
 string& ltrim(string& s);
 string& rtrim(string& s);
@@ -46,7 +60,10 @@ string ToLower(const string& s);
 string ToUpper(const string& s);
 
 // time
+// wall clock as "YYYY-MM-DD HH:MM:SS.uuuuuu"
 string GetTimeStamp();
+// monotonic clock in nanoseconds
+uint64_t GetMonotonicNs();
 
 // paths
 string GetApplicationPath();
@@ -65,6 +82,31 @@ void PrintPOD(const vector<T>& pod, size_t display_count = 0, const int precisio
 
 // logging
 void LogWrapper(int etype, const char* file, int line, const char* desc, ...);
+
+// blocks until every record logged so far has reached the console and file
+void LogFlush();
+
+// tracing
+// Events are kept in memory as 16 byte records (monotonic ns timestamp,
+// interned name, thread index, phase) and cost nothing while tracing is
+// disabled. Setting SDA_TRACE=<file.json> enables tracing at startup and
+// exports a Chrome trace (chrome://tracing, Perfetto) when the process exits.
+void TraceEnable(bool enable);
+bool TraceEnabled();
+void TraceEvent(int phase, const char* name);
+// raw records with their string and thread tables
+bool TraceSave(const char* filename);
+// Chrome trace event JSON, from memory or from a file written by TraceSave
+bool TraceExportChrome(const char* json_filename, const char* binary_filename = nullptr);
+
+class TraceSpan {
+   public:
+    explicit TraceSpan(const char* name) : m_name(name) { TraceEvent(etTraceBegin, m_name); }
+    ~TraceSpan() { TraceEvent(etTraceEnd, m_name); }
+
+   private:
+    const char* m_name;
+};
 }
 
 #endif /* LOGGER_H_ */
@@ -14,9 +14,15 @@
 * under the License.
 */
 #include "oclHelper.h"
+#include <sys/stat.h>
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
 #include <vector>
 
 //
@@ -148,6 +154,112 @@ oclHardware getOclHardware(cl_device_type type) {
     return hardware;
 }
 
+//
+// Program and kernel cache
+//
+namespace {
+
+struct CachedFile {
+    dev_t device;
+    ino_t inode;
+    off_t size;
+    struct timespec mtime;
+    unsigned long long hash;
+};
+
+struct CachedProgram {
+    cl_context context;
+    cl_device_id device;
+    cl_program program;
+    unsigned inUse; // kernels handed out and not yet released
+    std::map<std::string, std::vector<cl_kernel> > idleKernels;
+    std::list<CachedProgram*>::iterator lru;
+};
+
+typedef std::tuple<cl_context, cl_device_id, unsigned long long> ProgramKey;
+
+struct OclCache {
+    std::mutex lock;
+    unsigned limit;
+    std::map<std::string, CachedFile> files;
+    std::map<ProgramKey, CachedProgram*> programs;
+    std::map<cl_program, ProgramKey> keys;
+    std::list<CachedProgram*> lru; // most recently used first
+
+    OclCache() : limit(4) {}
+};
+
+OclCache& oclCache() {
+    static OclCache cache;
+    return cache;
+}
+
+// FNV-1a over the binary (or source) and the compile options
+unsigned long long hashProgram(const char* data, size_t size, const char* options) {
+    unsigned long long h = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++) {
+        h = (h ^ (unsigned char)data[i]) * 1099511628211ULL;
+    }
+    for (; *options; options++) {
+        h = (h ^ (unsigned char)*options) * 1099511628211ULL;
+    }
+    return h;
+}
+
+void destroyProgram(OclCache& cache, CachedProgram* entry) {
+    for (auto& idle : entry->idleKernels) {
+        for (auto kernel : idle.second) clReleaseKernel(kernel);
+    }
+    if (entry->inUse) {
+        // kernels still handed out release the program themselves through
+        // release(oclSoftware&), one reference each
+        for (unsigned i = 1; i < entry->inUse; i++) clRetainProgram(entry->program);
+    } else {
+        clReleaseProgram(entry->program);
+    }
+    cache.programs.erase(cache.keys[entry->program]);
+    cache.keys.erase(entry->program);
+    cache.lru.erase(entry->lru);
+    delete entry;
+}
+
+// Evict idle programs of a device, least recently used first, until at
+// most keep programs are left on it. Returns false if nothing was evicted.
+bool evictIdle(OclCache& cache, cl_device_id device, size_t keep) {
+    size_t onDevice = 0;
+    for (auto entry : cache.lru) {
+        if (entry->device == device) onDevice++;
+    }
+    std::vector<CachedProgram*> victims;
+    for (auto it = cache.lru.rbegin(); it != cache.lru.rend() && onDevice > keep; ++it) {
+        if ((*it)->device != device || (*it)->inUse) continue;
+        victims.push_back(*it);
+        onDevice--;
+    }
+    for (auto entry : victims) destroyProgram(cache, entry);
+    return !victims.empty();
+}
+
+} // namespace
+
+void setOclProgramCacheLimit(unsigned programsPerDevice) {
+    OclCache& cache = oclCache();
+    std::lock_guard<std::mutex> guard(cache.lock);
+    cache.limit = programsPerDevice ? programsPerDevice : 1;
+}
+
+unsigned flushOclCache() {
+    OclCache& cache = oclCache();
+    std::lock_guard<std::mutex> guard(cache.lock);
+    for (auto it = cache.lru.begin(); it != cache.lru.end();) {
+        CachedProgram* entry = *it;
+        ++it;
+        if (!entry->inUse) destroyProgram(cache, entry);
+    }
+    cache.files.clear();
+    return cache.programs.size();
+}
+
 //
 // Get OCL software
 //
@@ -159,34 +271,100 @@ int getOclSoftware(oclSoftware& software, const oclHardware& hardware) {
         return -1;
     }
 
-    unsigned char* kernelCode = 0;
-    std::cout << "Loading " << software.mFileName << "\n";
+    OclCache& cache = oclCache();
+    std::lock_guard<std::mutex> guard(cache.lock);
 
-    int size = loadFile2Memory(software.mFileName, (char**)&kernelCode);
-    if (size < 0) {
+    // The file is only read when it is new or changed on disk, otherwise
+    // the hash remembered for it is enough to find the program
+    unsigned char* kernelCode = 0;
+    int size = 0;
+    struct stat st;
+    if (stat(software.mFileName, &st) != 0) {
         std::cout << "Failed to load kernel\n";
         return -2;
     }
+    auto file = cache.files.find(software.mFileName);
+    if (file == cache.files.end() || file->second.device != st.st_dev || file->second.inode != st.st_ino ||
+        file->second.size != st.st_size || file->second.mtime.tv_sec != st.st_mtim.tv_sec ||
+        file->second.mtime.tv_nsec != st.st_mtim.tv_nsec) {
+        std::cout << "Loading " << software.mFileName << "\n";
+        size = loadFile2Memory(software.mFileName, (char**)&kernelCode);
+        if (size < 0) {
+            std::cout << "Failed to load kernel\n";
+            delete[] kernelCode;
+            return -2;
+        }
+        CachedFile info = {st.st_dev, st.st_ino, st.st_size, st.st_mtim,
+                           hashProgram((const char*)kernelCode, size, software.mCompileOptions)};
+        file = cache.files.insert(std::make_pair(std::string(software.mFileName), info)).first;
+        file->second = info;
+    }
+
+    ProgramKey key(hardware.mContext, hardware.mDevice, file->second.hash);
+    auto found = cache.programs.find(key);
+    CachedProgram* entry = found != cache.programs.end() ? found->second : nullptr;
+    if (entry == nullptr) {
+        if (kernelCode == 0) {
+            // known file whose program was evicted
+            std::cout << "Loading " << software.mFileName << "\n";
+            size = loadFile2Memory(software.mFileName, (char**)&kernelCode);
+            if (size < 0) {
+                std::cout << "Failed to load kernel\n";
+                delete[] kernelCode;
+                return -2;
+            }
+        }
+
+        cl_program program = 0;
+        do {
+            if (deviceType == CL_DEVICE_TYPE_ACCELERATOR) {
+                size_t n = size;
+                program = clCreateProgramWithBinary(hardware.mContext, 1, &hardware.mDevice, &n,
+                                                    (const unsigned char**)&kernelCode, 0, &err);
+            } else {
+                program = clCreateProgramWithSource(hardware.mContext, 1, (const char**)&kernelCode, 0, &err);
+            }
+            // the device could not take another binary, make room and retry.
+            // Other failures, such as a bad binary, are not helped by evicting.
+        } while ((err == CL_OUT_OF_RESOURCES || err == CL_OUT_OF_HOST_MEMORY ||
+                  err == CL_MEM_OBJECT_ALLOCATION_FAILURE) &&
+                 evictIdle(cache, hardware.mDevice, 0));
+        delete[] kernelCode;
+        if (!program || (err != CL_SUCCESS)) {
+            std::cout << oclErrorCode(err) << "\n";
+            return -3;
+        }
 
-    if (deviceType == CL_DEVICE_TYPE_ACCELERATOR) {
-        size_t n = size;
-        software.mProgram = clCreateProgramWithBinary(hardware.mContext, 1, &hardware.mDevice, &n,
-                                                      (const unsigned char**)&kernelCode, 0, &err);
+        evictIdle(cache, hardware.mDevice, cache.limit - 1);
+        entry = new CachedProgram();
+        entry->context = hardware.mContext;
+        entry->device = hardware.mDevice;
+        entry->program = program;
+        entry->inUse = 0;
+        entry->lru = cache.lru.insert(cache.lru.begin(), entry);
+        cache.programs[key] = entry;
+        cache.keys[program] = key;
     } else {
-        software.mProgram = clCreateProgramWithSource(hardware.mContext, 1, (const char**)&kernelCode, 0, &err);
-    }
-    if (!software.mProgram || (err != CL_SUCCESS)) {
-        std::cout << oclErrorCode(err) << "\n";
-        return -3;
+        delete[] kernelCode;
+        cache.lru.splice(cache.lru.begin(), cache.lru, entry->lru);
     }
 
-    software.mKernel = clCreateKernel(software.mProgram, software.mKernelName, nullptr);
-    if (software.mKernel == 0) {
-        std::cout << oclErrorCode(err) << "\n";
-        return -4;
+    std::vector<cl_kernel>& idle = entry->idleKernels[software.mKernelName];
+    cl_kernel kernel = 0;
+    if (!idle.empty()) {
+        kernel = idle.back();
+        idle.pop_back();
+    } else {
+        kernel = clCreateKernel(entry->program, software.mKernelName, &err);
+        if (kernel == 0) {
+            std::cout << oclErrorCode(err) << "\n";
+            return -4;
+        }
     }
 
-    delete[] kernelCode;
+    entry->inUse++;
+    software.mProgram = entry->program;
+    software.mKernel = kernel;
     return 0;
 }
 
@@ -194,11 +372,37 @@ int getOclSoftware(oclSoftware& software, const oclHardware& hardware) {
 // Release software and hardware
 //
 void release(oclSoftware& software) {
-    clReleaseKernel(software.mKernel);
-    clReleaseProgram(software.mProgram);
+    OclCache& cache = oclCache();
+    std::lock_guard<std::mutex> guard(cache.lock);
+    auto key = cache.keys.find(software.mProgram);
+    if (key == cache.keys.end()) {
+        // not made by getOclSoftware, or already flushed
+        clReleaseKernel(software.mKernel);
+        clReleaseProgram(software.mProgram);
+        return;
+    }
+
+    // keep both for the next getOclSoftware() of this kernel
+    CachedProgram* entry = cache.programs[key->second];
+    entry->idleKernels[software.mKernelName].push_back(software.mKernel);
+    if (entry->inUse) entry->inUse--;
+    software.mKernel = 0;
+    software.mProgram = 0;
 }
 
 void release(oclHardware& hardware) {
+    // cached programs cannot outlive their context, the ones whose kernels
+    // are still in use are handed over to those kernels
+    {
+        OclCache& cache = oclCache();
+        std::lock_guard<std::mutex> guard(cache.lock);
+        for (auto it = cache.lru.begin(); it != cache.lru.end();) {
+            CachedProgram* entry = *it;
+            ++it;
+            if (entry->context == hardware.mContext) destroyProgram(cache, entry);
+        }
+    }
+
     clReleaseCommandQueue(hardware.mQueue);
     clReleaseContext(hardware.mContext);
     if ((hardware.mMajorVersion >= 1) && (hardware.mMinorVersion > 1)) {
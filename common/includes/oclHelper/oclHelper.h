@@ -37,10 +37,26 @@ struct oclSoftware {
 
 oclHardware getOclHardware(cl_device_type type);
 
+//
+// Programs and kernels made by getOclSoftware() are cached per (context,
+// device, binary hash) and kernel name. Every call hands out its own
+// cl_kernel, reused from earlier release(oclSoftware&) calls when one is
+// idle, and the program stays alive while any of its kernels is in use.
+// Idle programs are evicted least recently used first when a device holds
+// more than the limit, or when creating a new program runs out of
+// resources because the device has to be reprogrammed. Releasing the
+// hardware drops its programs, those with kernels still in use are released
+// by the last of them.
+//
 int getOclSoftware(oclSoftware& software, const oclHardware& hardware);
 
 void release(oclSoftware& software);
 
+void setOclProgramCacheLimit(unsigned programsPerDevice);
+
+// drop every idle program and kernel, returns the number of programs left
+unsigned flushOclCache();
+
 void release(oclHardware& hardware);
 
 const char* oclErrorCode(cl_int code);
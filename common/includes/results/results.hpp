@@ -0,0 +1,175 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include <string>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace xcl {
+
+// Machine readable results of a benchmark. Every metric is identified by its
+// name and parameters, recording the same metric again adds a repeat, and the
+// file gives the min, median, max, mean and standard deviation of the
+// repeats. The file is written as JSON when the XCL_RESULTS environment
+// variable names it, so the free form log of the examples is unchanged, and
+// two files can be compared with common/utility/compare_results.py.
+class Results {
+   public:
+    // A parameter of a metric such as the buffer size, kept as text
+    struct Param {
+        Param(const std::string& key, const std::string& value) : key(key), value(value) {}
+        Param(const std::string& key, const char* value) : key(key), value(value) {}
+        template <typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+        Param(const std::string& key, T value) : key(key) {
+            std::ostringstream ss;
+            ss << value;
+            this->value = ss.str();
+        }
+        std::string key;
+        std::string value;
+    };
+    typedef std::vector<Param> Params;
+
+    enum Better { HIGHER, LOWER };
+
+    explicit Results(const std::string& benchmark) : m_benchmark(benchmark) {}
+
+    // Records a sample of metric name in unit. better tells the comparator
+    // in which direction a change is a regression.
+    void add(const std::string& name,
+             const std::string& unit,
+             const Params& params,
+             double value,
+             Better better = HIGHER) {
+        for (auto& metric : m_metrics) {
+            if (metric.name == name && same(metric.params, params)) {
+                metric.samples.push_back(value);
+                return;
+            }
+        }
+        m_metrics.push_back(Metric{name, unit, params, better, {value}});
+    }
+
+    // Writes the results to the file named by XCL_RESULTS, if it is set.
+    // Returns false if the file cannot be written.
+    bool write() const {
+        const char* path = getenv("XCL_RESULTS");
+        if (path == nullptr || *path == '\0') return true;
+        return write(path);
+    }
+
+    bool write(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out) {
+            std::cout << "Error: Failed to write results to " << path << std::endl;
+            return false;
+        }
+        char host[256] = "";
+        gethostname(host, sizeof(host) - 1);
+        char stamp[32];
+        time_t now = time(nullptr);
+        strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+        out.precision(9);
+        out << "{\n  \"benchmark\": " << quote(m_benchmark) << ",\n  \"host\": " << quote(host)
+            << ",\n  \"timestamp\": " << quote(stamp) << ",\n  \"metrics\": [";
+        for (size_t m = 0; m < m_metrics.size(); m++) {
+            const Metric& metric = m_metrics[m];
+            std::vector<double> sorted = metric.samples;
+            std::sort(sorted.begin(), sorted.end());
+            size_t n = sorted.size();
+            double median = (n % 2) ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+            double mean = 0;
+            for (auto v : sorted) mean += v;
+            mean /= n;
+            double var = 0;
+            for (auto v : sorted) var += (v - mean) * (v - mean);
+            double stddev = (n > 1) ? std::sqrt(var / (n - 1)) : 0;
+
+            out << (m ? ",\n" : "\n") << "    {\"name\": " << quote(metric.name) << ", \"unit\": " << quote(metric.unit)
+                << ", \"better\": " << quote(metric.better == HIGHER ? "higher" : "lower") << ",\n     \"params\": {";
+            for (size_t p = 0; p < metric.params.size(); p++) {
+                out << (p ? ", " : "") << quote(metric.params[p].key) << ": " << quote(metric.params[p].value);
+            }
+            out << "},\n     \"repeats\": " << n << ", \"min\": " << number(sorted.front())
+                << ", \"median\": " << number(median) << ", \"max\": " << number(sorted.back())
+                << ", \"mean\": " << number(mean) << ", \"stddev\": " << number(stddev) << ",\n     \"samples\": [";
+            for (size_t i = 0; i < n; i++) out << (i ? ", " : "") << number(metric.samples[i]);
+            out << "]}";
+        }
+        out << "\n  ]\n}\n";
+        return true;
+    }
+
+   private:
+    struct Metric {
+        std::string name;
+        std::string unit;
+        Params params;
+        Better better;
+        std::vector<double> samples;
+    };
+
+    static bool same(const Params& a, const Params& b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); i++) {
+            if (a[i].key != b[i].key || a[i].value != b[i].value) return false;
+        }
+        return true;
+    }
+
+    static std::string quote(const std::string& s) {
+        std::string out = "\"";
+        for (char c : s) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += c;
+            } else if ((unsigned char)c < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            } else {
+                out += c;
+            }
+        }
+        return out + "\"";
+    }
+
+    // JSON has no inf or nan
+    static std::string number(double v) {
+        if (!std::isfinite(v)) return "null";
+        std::ostringstream ss;
+        ss.precision(9);
+        ss << v;
+        return ss.str();
+    }
+
+    std::string m_benchmark;
+    std::vector<Metric> m_metrics;
+};
+}
@@ -18,63 +18,117 @@
 #include <stdio.h>
 #include <stdlib.h>
 
-int writebmp(char* filename, struct bmp_t* bitmap) {
-    // 24 bpp uncompressed
-
-    FILE* fp = fopen(filename, "w+b");
-    if (fp == nullptr) return -1;
+// stdio buffer used by the streams, large enough that a band of rows
+// turns into a few big reads or writes
+#define BMP_STREAM_BUFFER (1 << 20)
 
+static void init_header(struct bmpheader_t* header, uint32_t width, uint32_t height, uint32_t stride) {
     // compute dib entries
-    bitmap->header.dibheadersize = 40;
-    bitmap->header.dibwidth = bitmap->width;
-    bitmap->header.dibheight = bitmap->height;
-    bitmap->header.dibplane = 1;
-    bitmap->header.dibdepth = 24;
-    bitmap->header.dibcompression = 0;
-    bitmap->header.dibsize = (bitmap->width) * (bitmap->height) * (bitmap->header.dibdepth / 8);
-    bitmap->header.dibhor = 2835;
-    bitmap->header.dibver = 2835;
-    bitmap->header.dibpal = 0;
-    bitmap->header.dibimportant = 0;
+    header->dibheadersize = 40;
+    header->dibwidth = width;
+    header->dibheight = height;
+    header->dibplane = 1;
+    header->dibdepth = 24;
+    header->dibcompression = 0;
+    header->dibsize = stride * height;
+    header->dibhor = 2835;
+    header->dibver = 2835;
+    header->dibpal = 0;
+    header->dibimportant = 0;
 
     // compute header entries
-    bitmap->header.headerB = 'B';
-    bitmap->header.headerM = 'M';
-    bitmap->header.headerpixelsoffset = 54;
-    bitmap->header.headerbmpsize = bitmap->header.dibsize + bitmap->header.headerpixelsoffset;
-    bitmap->header.headerapp0 = 0;
-    bitmap->header.headerapp1 = 0;
+    header->headerB = 'B';
+    header->headerM = 'M';
+    header->headerpixelsoffset = 54;
+    header->headerbmpsize = header->dibsize + header->headerpixelsoffset;
+    header->headerapp0 = 0;
+    header->headerapp1 = 0;
+}
 
+static void write_header(FILE* fp, struct bmpheader_t* header) {
     // write header
-    fwrite(&(bitmap->header.headerB), 1, 1, fp);
-    fwrite(&(bitmap->header.headerM), 1, 1, fp);
-    fwrite(&(bitmap->header.headerbmpsize), 4, 1, fp);
-    fwrite(&(bitmap->header.headerapp0), 2, 1, fp);
-    fwrite(&(bitmap->header.headerapp1), 2, 1, fp);
-    fwrite(&(bitmap->header.headerpixelsoffset), 4, 1, fp);
+    fwrite(&(header->headerB), 1, 1, fp);
+    fwrite(&(header->headerM), 1, 1, fp);
+    fwrite(&(header->headerbmpsize), 4, 1, fp);
+    fwrite(&(header->headerapp0), 2, 1, fp);
+    fwrite(&(header->headerapp1), 2, 1, fp);
+    fwrite(&(header->headerpixelsoffset), 4, 1, fp);
 
     // write dib header
-    fwrite(&(bitmap->header.dibheadersize), 4, 1, fp);
-    fwrite(&(bitmap->header.dibwidth), 4, 1, fp);
-    fwrite(&(bitmap->header.dibheight), 4, 1, fp);
-    fwrite(&(bitmap->header.dibplane), 2, 1, fp);
-    fwrite(&(bitmap->header.dibdepth), 2, 1, fp);
-    fwrite(&(bitmap->header.dibcompression), 4, 1, fp);
-    fwrite(&(bitmap->header.dibsize), 4, 1, fp);
-    fwrite(&(bitmap->header.dibhor), 4, 1, fp);
-    fwrite(&(bitmap->header.dibver), 4, 1, fp);
-    fwrite(&(bitmap->header.dibpal), 4, 1, fp);
-    fwrite(&(bitmap->header.dibimportant), 4, 1, fp);
+    fwrite(&(header->dibheadersize), 4, 1, fp);
+    fwrite(&(header->dibwidth), 4, 1, fp);
+    fwrite(&(header->dibheight), 4, 1, fp);
+    fwrite(&(header->dibplane), 2, 1, fp);
+    fwrite(&(header->dibdepth), 2, 1, fp);
+    fwrite(&(header->dibcompression), 4, 1, fp);
+    fwrite(&(header->dibsize), 4, 1, fp);
+    fwrite(&(header->dibhor), 4, 1, fp);
+    fwrite(&(header->dibver), 4, 1, fp);
+    fwrite(&(header->dibpal), 4, 1, fp);
+    fwrite(&(header->dibimportant), 4, 1, fp);
+}
 
-    // write pixels
-    fwrite(bitmap->pixels, bitmap->header.dibsize, 1, fp);
+static int read_header(FILE* fp, struct bmpheader_t* header) {
+    // read header
+    fread(&(header->headerB), 1, 1, fp);
+    fread(&(header->headerM), 1, 1, fp);
+    fread(&(header->headerbmpsize), 4, 1, fp);
+    fread(&(header->headerapp0), 2, 1, fp);
+    fread(&(header->headerapp1), 2, 1, fp);
+    fread(&(header->headerpixelsoffset), 4, 1, fp);
+    // read dib header
+    fread(&(header->dibheadersize), 4, 1, fp);
+    fread(&(header->dibwidth), 4, 1, fp);
+    fread(&(header->dibheight), 4, 1, fp);
+    fread(&(header->dibplane), 2, 1, fp);
+    fread(&(header->dibdepth), 2, 1, fp);
+    fread(&(header->dibcompression), 4, 1, fp);
+    fread(&(header->dibsize), 4, 1, fp);
+    fread(&(header->dibhor), 4, 1, fp);
+    fread(&(header->dibver), 4, 1, fp);
+    fread(&(header->dibpal), 4, 1, fp);
+    fread(&(header->dibimportant), 4, 1, fp);
 
     if (ferror(fp)) return -1;
 
-    fclose(fp);
+    // validate header
+    // header
+    if (header->headerB != 'B') return -2;
+    if (header->headerM != 'M') return -2;
+    // headerbmpsize
+    if (header->headerapp0 != 0) return -2;
+    if (header->headerapp1 != 0) return -2;
+    if (header->headerpixelsoffset != 54) return -2;
+    // dib header
+    if (header->dibheadersize != 40) return -2;
+    if (header->dibplane != 1) return -2;
+    if (header->dibdepth != 24) return -2;
+    if (header->dibcompression != 0) return -2;
+    // dibsize checked by the callers
+    // dibhor unused
+    // dibver unused
+    if (header->dibpal != 0) return -2;
+    if (header->dibimportant != 0) return -2;
     return 0;
 }
 
+int writebmp(char* filename, struct bmp_t* bitmap) {
+    // 24 bpp uncompressed
+
+    FILE* fp = fopen(filename, "w+b");
+    if (fp == nullptr) return -1;
+
+    init_header(&(bitmap->header), bitmap->width, bitmap->height, bitmap->width * 3);
+    write_header(fp, &(bitmap->header));
+
+    // write pixels
+    fwrite(bitmap->pixels, bitmap->header.dibsize, 1, fp);
+
+    int ret = ferror(fp) ? -1 : 0;
+    fclose(fp);
+    return ret;
+}
+
 int readbmp(char* filename, struct bmp_t* bitmap) {
     //-1 file access error
     //-2 invalid BMP
@@ -82,57 +136,114 @@ int readbmp(char* filename, struct bmp_t* bitmap) {
     FILE* fp = fopen(filename, "r+b");
     if (fp == nullptr) return -1;
 
-    // read header
-    fread(&(bitmap->header.headerB), 1, 1, fp);
-    fread(&(bitmap->header.headerM), 1, 1, fp);
-    fread(&(bitmap->header.headerbmpsize), 4, 1, fp);
-    fread(&(bitmap->header.headerapp0), 2, 1, fp);
-    fread(&(bitmap->header.headerapp1), 2, 1, fp);
-    fread(&(bitmap->header.headerpixelsoffset), 4, 1, fp);
-    // read dib header
-    fread(&(bitmap->header.dibheadersize), 4, 1, fp);
-    fread(&(bitmap->header.dibwidth), 4, 1, fp);
-    fread(&(bitmap->header.dibheight), 4, 1, fp);
-    fread(&(bitmap->header.dibplane), 2, 1, fp);
-    fread(&(bitmap->header.dibdepth), 2, 1, fp);
-    fread(&(bitmap->header.dibcompression), 4, 1, fp);
-    fread(&(bitmap->header.dibsize), 4, 1, fp);
-    fread(&(bitmap->header.dibhor), 4, 1, fp);
-    fread(&(bitmap->header.dibver), 4, 1, fp);
-    fread(&(bitmap->header.dibpal), 4, 1, fp);
-    fread(&(bitmap->header.dibimportant), 4, 1, fp);
-
-    if (ferror(fp)) return -1;
-
-    // validate header
-    // header
-    if (bitmap->header.headerB != 'B') return -2;
-    if (bitmap->header.headerM != 'M') return -2;
-    // headerbmpsize
-    if (bitmap->header.headerapp0 != 0) return -2;
-    if (bitmap->header.headerapp1 != 0) return -2;
-    if (bitmap->header.headerpixelsoffset != 54) return -2;
-    // dib header
-    if (bitmap->header.dibheadersize != 40) return -2;
+    int ret = read_header(fp, &(bitmap->header));
     bitmap->width = bitmap->header.dibwidth;
     bitmap->height = bitmap->header.dibheight;
-    if (bitmap->header.dibplane != 1) return -2;
-    if (bitmap->header.dibdepth != 24) return -2;
-    if (bitmap->header.dibcompression != 0) return -2;
-    if (bitmap->header.dibsize != (bitmap->header.dibwidth * bitmap->header.dibheight * 3)) return -2;
-    // dibsize do nothing yet
-    // dibhor unused
-    // dibver unused
-    if (bitmap->header.dibpal != 0) return -2;
-    if (bitmap->header.dibimportant != 0) return -2;
+    if (ret == 0 && bitmap->header.dibsize != (bitmap->header.dibwidth * bitmap->header.dibheight * 3)) ret = -2;
 
     // read pixels
-    bitmap->pixels = (uint32_t*)malloc(bitmap->header.dibsize);
-    if (bitmap->pixels == nullptr) return -3;
-    fread(bitmap->pixels, bitmap->header.dibsize, 1, fp);
-
-    if (ferror(fp)) return -1;
+    if (ret == 0) {
+        bitmap->pixels = (uint32_t*)malloc(bitmap->header.dibsize);
+        if (bitmap->pixels == nullptr) ret = -3;
+    }
+    if (ret == 0) {
+        fread(bitmap->pixels, bitmap->header.dibsize, 1, fp);
+        if (ferror(fp)) ret = -1;
+    }
 
     fclose(fp);
-    return 0;
+    return ret;
+}
+
+int bmp_open_read(char* filename, struct bmp_stream_t* stream) {
+    stream->fp = fopen(filename, "rb");
+    if (stream->fp == nullptr) return -1;
+    setvbuf(stream->fp, nullptr, _IOFBF, BMP_STREAM_BUFFER);
+
+    int ret = read_header(stream->fp, &(stream->header));
+    stream->width = stream->header.dibwidth;
+    stream->height = stream->header.dibheight;
+    stream->row = 0;
+    stream->writing = 0;
+
+    // Rows are either packed, as written by writebmp(), or padded to a
+    // multiple of 4 bytes as the BMP format asks for
+    uint32_t packed = stream->width * 3;
+    uint32_t padded = (packed + 3) & ~3u;
+    if (ret == 0 && stream->header.dibsize == padded * stream->height)
+        stream->stride = padded;
+    else if (ret == 0 && stream->header.dibsize == packed * stream->height)
+        stream->stride = packed;
+    else if (ret == 0)
+        ret = -2;
+
+    if (ret != 0) {
+        fclose(stream->fp);
+        stream->fp = nullptr;
+    }
+    return ret;
+}
+
+int bmp_open_write(char* filename, uint32_t width, uint32_t height, struct bmp_stream_t* stream) {
+    stream->fp = fopen(filename, "wb");
+    if (stream->fp == nullptr) return -1;
+    setvbuf(stream->fp, nullptr, _IOFBF, BMP_STREAM_BUFFER);
+
+    stream->width = width;
+    stream->height = height;
+    stream->stride = (width * 3 + 3) & ~3u;
+    stream->row = 0;
+    stream->writing = 1;
+    init_header(&(stream->header), width, height, stream->stride);
+    write_header(stream->fp, &(stream->header));
+
+    return ferror(stream->fp) ? -1 : 0;
+}
+
+int bmp_read_rows(struct bmp_stream_t* stream, void* buf, uint32_t nrows, size_t buf_stride) {
+    if (stream->fp == nullptr || stream->writing) return -1;
+    if (nrows > stream->height - stream->row) nrows = stream->height - stream->row;
+    if (nrows == 0) return 0;
+
+    char* dst = (char*)buf;
+    size_t row_bytes = stream->width * 3;
+    if (buf_stride == stream->stride) {
+        // same layout as the file, one read for the whole band
+        if (fread(dst, (size_t)stream->stride * nrows, 1, stream->fp) != 1) return -1;
+    } else {
+        char pad[4];
+        for (uint32_t i = 0; i < nrows; i++) {
+            if (fread(dst + i * buf_stride, row_bytes, 1, stream->fp) != 1) return -1;
+            if (stream->stride > row_bytes && fread(pad, stream->stride - row_bytes, 1, stream->fp) != 1) return -1;
+        }
+    }
+    stream->row += nrows;
+    return nrows;
+}
+
+int bmp_write_rows(struct bmp_stream_t* stream, const void* buf, uint32_t nrows, size_t buf_stride) {
+    if (stream->fp == nullptr || !stream->writing) return -1;
+    if (nrows > stream->height - stream->row) return -2;
+
+    const char* src = (const char*)buf;
+    size_t row_bytes = stream->width * 3;
+    const char pad[4] = {0, 0, 0, 0};
+    for (uint32_t i = 0; i < nrows; i++) {
+        fwrite(src + i * buf_stride, row_bytes, 1, stream->fp);
+        if (stream->stride > row_bytes) fwrite(pad, stream->stride - row_bytes, 1, stream->fp);
+    }
+    if (ferror(stream->fp)) return -1;
+    stream->row += nrows;
+    return nrows;
+}
+
+int bmp_close(struct bmp_stream_t* stream) {
+    if (stream->fp == nullptr) return -1;
+
+    int ret = ferror(stream->fp) ? -1 : 0;
+    // a written image must be complete to be valid
+    if (ret == 0 && stream->writing && stream->row != stream->height) ret = -2;
+    if (fclose(stream->fp) != 0 && ret == 0) ret = -1;
+    stream->fp = nullptr;
+    return ret;
 }
@@ -20,6 +20,10 @@
 #ifndef __SIMPLE_BMP
 #define __SIMPLE_BMP
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
 struct bmpheader_t {
     // Header
     char headerB;
@@ -57,4 +61,39 @@ int readbmp(char* filename, struct bmp_t* bitmap);
 //-2 invalid BMP
 //-3 memory allocation error
 
+// Streaming access in bands of rows, for images that should not (or cannot)
+// be held in host memory at once. Rows are visited in file order (bottom
+// row first) and each band is copied to or from a caller buffer whose rows
+// are buf_stride bytes apart, so a band can land directly in a pinned or
+// device mapped buffer. Alternating between two such buffers lets the read
+// of band n+1 overlap the transfer and kernel run of band n:
+//
+//   bmp_open_read(in, &rd);
+//   bmp_open_write(out, rd.width, rd.height, &wr);
+//   while ((n = bmp_read_rows(&rd, buf[i], band, stride)) > 0) {
+//       ... enqueue buf[i], wait for buf[i ^ 1], bmp_write_rows(&wr, ...)
+//       i ^= 1;
+//   }
+//   bmp_close(&rd);
+//   bmp_close(&wr);
+struct bmp_stream_t {
+    struct bmpheader_t header;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride; // bytes per row in the file
+    uint32_t row;    // next row to read or write
+    int writing;
+    FILE* fp;
+};
+
+int bmp_open_read(char* filename, struct bmp_stream_t* stream);
+int bmp_open_write(char* filename, uint32_t width, uint32_t height, struct bmp_stream_t* stream);
+// returns the number of rows copied, 0 once every row is done, or an error
+int bmp_read_rows(struct bmp_stream_t* stream, void* buf, uint32_t nrows, size_t buf_stride);
+int bmp_write_rows(struct bmp_stream_t* stream, const void* buf, uint32_t nrows, size_t buf_stride);
+int bmp_close(struct bmp_stream_t* stream);
+//-1 file access error
+//-2 invalid BMP, or writing past the last row
+//-3 memory allocation error
+
 #endif
@@ -0,0 +1,148 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+#include "verify.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define VERIFY_X86_SIMD 1
+#endif
+
+// Bytes compared by a worker at a time
+#define VERIFY_BLOCK (1 << 20)
+
+namespace xcl {
+
+// The block compares only answer whether a block is identical. They OR the
+// differences of several vectors together and test once per iteration, so
+// the common all equal case has a single branch per 128 or 256 bytes. The
+// SIMD variants are selected at runtime so the default -O0 host build still
+// gets them.
+static bool block_equal_scalar(const char* a, const char* b, size_t size) {
+    return memcmp(a, b, size) == 0;
+}
+
+#ifdef VERIFY_X86_SIMD
+__attribute__((target("avx2"))) static bool block_equal_avx2(const char* a, const char* b, size_t size) {
+    size_t i = 0;
+    for (; i + 128 <= size; i += 128) {
+        __m256i d0 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + i)),
+                                      _mm256_loadu_si256((const __m256i*)(b + i)));
+        __m256i d1 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + i + 32)),
+                                      _mm256_loadu_si256((const __m256i*)(b + i + 32)));
+        __m256i d2 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + i + 64)),
+                                      _mm256_loadu_si256((const __m256i*)(b + i + 64)));
+        __m256i d3 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + i + 96)),
+                                      _mm256_loadu_si256((const __m256i*)(b + i + 96)));
+        __m256i acc = _mm256_or_si256(_mm256_or_si256(d0, d1), _mm256_or_si256(d2, d3));
+        if (!_mm256_testz_si256(acc, acc)) return false;
+    }
+    return block_equal_scalar(a + i, b + i, size - i);
+}
+
+__attribute__((target("avx512f"))) static bool block_equal_avx512(const char* a, const char* b, size_t size) {
+    size_t i = 0;
+    for (; i + 256 <= size; i += 256) {
+        __m512i d0 = _mm512_xor_si512(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i));
+        __m512i d1 = _mm512_xor_si512(_mm512_loadu_si512(a + i + 64), _mm512_loadu_si512(b + i + 64));
+        __m512i d2 = _mm512_xor_si512(_mm512_loadu_si512(a + i + 128), _mm512_loadu_si512(b + i + 128));
+        __m512i d3 = _mm512_xor_si512(_mm512_loadu_si512(a + i + 192), _mm512_loadu_si512(b + i + 192));
+        __m512i acc = _mm512_or_si512(_mm512_or_si512(d0, d1), _mm512_or_si512(d2, d3));
+        if (_mm512_test_epi64_mask(acc, acc)) return false;
+    }
+    return block_equal_scalar(a + i, b + i, size - i);
+}
+#endif
+
+typedef bool (*block_equal_fn)(const char*, const char*, size_t);
+
+static block_equal_fn select_block_equal() {
+#ifdef VERIFY_X86_SIMD
+    if (__builtin_cpu_supports("avx512f")) return block_equal_avx512;
+    if (__builtin_cpu_supports("avx2")) return block_equal_avx2;
+#endif
+    return block_equal_scalar;
+}
+
+// Only called for a block known to differ
+static size_t locate_mismatch(const char* a, const char* b, size_t size) {
+    size_t i = 0;
+    for (; i + 64 <= size && memcmp(a + i, b + i, 64) == 0; i += 64)
+        ;
+    for (; i < size && a[i] == b[i]; i++)
+        ;
+    return i;
+}
+
+unsigned verify_threads() {
+    unsigned threads = std::thread::hardware_concurrency();
+    return threads ? threads : 1;
+}
+
+// Workers take the next range until every range is done, the same scheme
+// as xcl::program_all
+static void run_workers(size_t num_tasks, unsigned max_threads, const std::function<void(size_t task)>& fn) {
+    size_t threads = max_threads ? max_threads : verify_threads();
+    if (threads > num_tasks) threads = num_tasks;
+
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t t = next++; t < num_tasks; t = next++) fn(t);
+    };
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (auto& thread : pool) thread.join();
+}
+
+void parallel_for(size_t count,
+                  const std::function<void(size_t begin, size_t end)>& fn,
+                  size_t grain,
+                  unsigned max_threads) {
+    if (count == 0) return;
+    if (grain == 0) grain = 1;
+    size_t num_tasks = (count + grain - 1) / grain;
+    run_workers(num_tasks, max_threads, [&](size_t t) { fn(t * grain, std::min(count, (t + 1) * grain)); });
+}
+
+size_t first_mismatch(const void* a, const void* b, size_t size, unsigned max_threads) {
+    const char* pa = (const char*)a;
+    const char* pb = (const char*)b;
+    block_equal_fn block_equal = select_block_equal();
+
+    // Blocks are handed out in order, so once a difference is known every
+    // block after it can be skipped
+    std::atomic<size_t> first(size);
+    size_t num_blocks = (size + VERIFY_BLOCK - 1) / VERIFY_BLOCK;
+    run_workers(num_blocks, max_threads, [&](size_t t) {
+        size_t begin = t * VERIFY_BLOCK;
+        if (begin >= first.load()) return;
+        size_t len = std::min<size_t>(VERIFY_BLOCK, size - begin);
+        if (block_equal(pa + begin, pb + begin, len)) return;
+
+        size_t offset = begin + locate_mismatch(pa + begin, pb + begin, len);
+        size_t current = first.load();
+        while (offset < current && !first.compare_exchange_weak(current, offset))
+            ;
+    });
+    return first.load();
+}
+}
@@ -0,0 +1,54 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+#pragma once
+
+#include <functional>
+#include <iostream>
+#include <stddef.h>
+#include <string>
+
+// Host side helpers to build reference data and check device results for
+// large buffers. The work is split into blocks that all cores take in turn,
+// and the comparison uses AVX-512 or AVX2 when the CPU supports them.
+namespace xcl {
+// Number of threads used when max_threads is 0: all hardware threads
+unsigned verify_threads();
+
+// Calls fn(begin, end) for consecutive ranges covering [0, count) from
+// several threads. Ranges are at least grain elements long.
+void parallel_for(size_t count,
+                  const std::function<void(size_t begin, size_t end)>& fn,
+                  size_t grain = 1 << 20,
+                  unsigned max_threads = 0);
+
+// Byte offset of the first difference between a and b, or size if both
+// buffers are identical. Blocks are compared wide first and only a block
+// that differs is searched byte by byte.
+size_t first_mismatch(const void* a, const void* b, size_t size, unsigned max_threads = 0);
+
+// Compares count elements of the device result against the reference. On
+// a mismatch prints the first differing element and returns false.
+template <typename T>
+bool verify(const std::string& name, const T* expected, const T* actual, size_t count, unsigned max_threads = 0) {
+    size_t offset = first_mismatch(expected, actual, count * sizeof(T), max_threads);
+    if (offset == count * sizeof(T)) return true;
+    size_t i = offset / sizeof(T);
+    std::cout << "Error: Result mismatch in " << name << std::endl;
+    std::cout << "i = " << i << " CPU result = " << expected[i] << " Device result = " << actual[i] << std::endl;
+    return false;
+}
+}
@@ -15,14 +15,22 @@
 */
 
 #include "xcl2.hpp"
+#include <atomic>
+#include <chrono>
 #include <climits>
 #include <sys/stat.h>
 #include <string>
 #include <iomanip>
+#include <map>
+#include <mutex>
 #include <sstream>
+#include <thread>
 #if defined(_WINDOWS)
 #include <io.h>
 #else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 #endif
 
@@ -62,6 +70,60 @@ std::vector<cl::Device> get_xil_devices() {
     return get_devices("Xilinx");
 }
 
+EventTimes get_event_times(const cl::Event& event) {
+    cl_int err;
+    EventTimes times;
+    OCL_CHECK(err, times.queued = event.getProfilingInfo<CL_PROFILING_COMMAND_QUEUED>(&err));
+    OCL_CHECK(err, times.submit = event.getProfilingInfo<CL_PROFILING_COMMAND_SUBMIT>(&err));
+    OCL_CHECK(err, times.start = event.getProfilingInfo<CL_PROFILING_COMMAND_START>(&err));
+    OCL_CHECK(err, times.end = event.getProfilingInfo<CL_PROFILING_COMMAND_END>(&err));
+    return times;
+}
+
+std::vector<ProgrammedDevice> program_all(const std::vector<cl::Device>& devices,
+                                          const std::vector<std::string>& binaries,
+                                          cl_command_queue_properties queue_props,
+                                          const cl_context_properties* context_props,
+                                          unsigned max_threads) {
+    std::vector<ProgrammedDevice> result(devices.size());
+    if (binaries.size() != 1 && binaries.size() != devices.size()) {
+        std::cout << "Error: program_all needs one xclbin, or one per device" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    // Workers take the next device until every device is done
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t d = next++; d < devices.size(); d = next++) {
+            ProgrammedDevice& out = result[d];
+            auto start = std::chrono::high_resolution_clock::now();
+            out.device = devices[d];
+            out.binary = map_binary_file(binaries.size() == 1 ? binaries[0] : binaries[d]);
+            cl::Program::Binaries bins{{out.binary->data(), out.binary->size()}};
+
+            out.context = cl::Context(devices[d], context_props, nullptr, nullptr, &out.err);
+            if (out.err == CL_SUCCESS) out.queue = cl::CommandQueue(out.context, devices[d], queue_props, &out.err);
+            if (out.err == CL_SUCCESS) out.program = cl::Program(out.context, {devices[d]}, bins, nullptr, &out.err);
+            auto end = std::chrono::high_resolution_clock::now();
+            out.program_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        }
+    };
+
+    size_t threads = devices.size();
+    if (max_threads != 0 && max_threads < threads) threads = max_threads;
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (auto& thread : pool) thread.join();
+
+    for (size_t d = 0; d < result.size(); d++) {
+        std::cout << "Device[" << d << "]: " << result[d].binary->name()
+                  << (result[d].err == CL_SUCCESS ? " programmed in " : " failed to program after ") << std::fixed
+                  << std::setprecision(1) << result[d].program_ms << " ms" << std::defaultfloat << std::endl;
+    }
+    return result;
+}
+
 cl::Device find_device_bdf(const std::vector<cl::Device>& devices, const std::string& bdf) {
     char device_bdf[20];
     cl_int err;
@@ -105,22 +167,333 @@ cl_device_id find_device_bdf_c(cl_device_id* devices, const std::string& bdf, cl
     return device;
 }
 std::vector<unsigned char> read_binary_file(const std::string& xclbin_file_name) {
+    auto view = map_binary_file(xclbin_file_name);
+    return std::vector<unsigned char>(view->data(), view->data() + view->size());
+}
+
+BinaryView::BinaryView(const std::string& xclbin_file_name)
+    : m_name(xclbin_file_name), m_data(nullptr), m_size(0), m_hash(0), m_hashed(false) {
     std::cout << "INFO: Reading " << xclbin_file_name << std::endl;
-    FILE* fp;
-    if ((fp = fopen(xclbin_file_name.c_str(), "r")) == nullptr) {
+#if defined(_WINDOWS)
+    std::ifstream bin_file(xclbin_file_name.c_str(), std::ifstream::binary);
+    if (!bin_file) {
         printf("ERROR: %s xclbin not available please build\n", xclbin_file_name.c_str());
         exit(EXIT_FAILURE);
     }
-    // Loading XCL Bin into char buffer
     std::cout << "Loading: '" << xclbin_file_name.c_str() << "'\n";
-    std::ifstream bin_file(xclbin_file_name.c_str(), std::ifstream::binary);
     bin_file.seekg(0, bin_file.end);
-    auto nb = bin_file.tellg();
+    m_buf.resize(bin_file.tellg());
     bin_file.seekg(0, bin_file.beg);
-    std::vector<unsigned char> buf;
-    buf.resize(nb);
-    bin_file.read(reinterpret_cast<char*>(buf.data()), nb);
-    return buf;
+    bin_file.read(reinterpret_cast<char*>(m_buf.data()), m_buf.size());
+    m_data = m_buf.data();
+    m_size = m_buf.size();
+#else
+    int fd = open(xclbin_file_name.c_str(), O_RDONLY);
+    if (fd < 0) {
+        printf("ERROR: %s xclbin not available please build\n", xclbin_file_name.c_str());
+        exit(EXIT_FAILURE);
+    }
+    struct stat sb;
+    if (fstat(fd, &sb) != 0 || sb.st_size == 0) {
+        printf("ERROR: %s xclbin is empty or unreadable\n", xclbin_file_name.c_str());
+        close(fd);
+        exit(EXIT_FAILURE);
+    }
+    // Loading XCL Bin by mapping it, the runtime reads straight from the page cache
+    std::cout << "Loading: '" << xclbin_file_name.c_str() << "'\n";
+    m_size = sb.st_size;
+    void* addr = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        printf("ERROR: failed to map %s\n", xclbin_file_name.c_str());
+        exit(EXIT_FAILURE);
+    }
+    madvise(addr, m_size, MADV_SEQUENTIAL);
+    m_data = static_cast<const unsigned char*>(addr);
+#endif
+}
+
+BinaryView::~BinaryView() {
+#if !defined(_WINDOWS)
+    if (m_data != nullptr) munmap(const_cast<unsigned char*>(m_data), m_size);
+#endif
+}
+
+uint64_t BinaryView::hash() const {
+    if (!m_hashed) {
+        uint64_t h = 14695981039346656037ULL;
+        for (size_t i = 0; i < m_size; i++) {
+            h ^= m_data[i];
+            h *= 1099511628211ULL;
+        }
+        m_hash = h;
+        m_hashed = true;
+    }
+    return m_hash;
+}
+
+namespace {
+// What identifies a version of a file on disk. Windows has no inode and only
+// whole seconds, so there the path, size and time have to do.
+struct FileStamp {
+    uint64_t dev;
+    uint64_t ino;
+    uint64_t size;
+    int64_t sec;
+    int64_t nsec;
+
+    bool operator==(const FileStamp& o) const {
+        return dev == o.dev && ino == o.ino && size == o.size && sec == o.sec && nsec == o.nsec;
+    }
+};
+
+FileStamp file_stamp(const struct stat& sb) {
+#if defined(_WINDOWS)
+    return {0, 0, (uint64_t)sb.st_size, (int64_t)sb.st_mtime, 0};
+#else
+    // Modification times are compared to the nanosecond, a rebuild within
+    // the same second is still seen unless the filesystem only keeps seconds
+    return {(uint64_t)sb.st_dev, (uint64_t)sb.st_ino, (uint64_t)sb.st_size, (int64_t)sb.st_mtim.tv_sec,
+            (int64_t)sb.st_mtim.tv_nsec};
+#endif
+}
+
+struct BinaryCacheEntry {
+    FileStamp stamp;
+    uint64_t hash; // content hash taken when the file was first mapped
+    std::shared_ptr<const BinaryView> view;
+};
+std::mutex g_binary_cache_mutex;
+std::map<std::string, BinaryCacheEntry> g_binary_cache;
+
+// Entry of the file with this stamp, under its own path or, where inodes
+// exist, another path of the same file (symlink, relative path)
+const BinaryCacheEntry* find_binary(const std::string& name, const FileStamp& stamp) {
+    auto it = g_binary_cache.find(name);
+    if (it != g_binary_cache.end() && it->second.stamp == stamp) return &it->second;
+#if !defined(_WINDOWS)
+    for (auto& kv : g_binary_cache) {
+        if (kv.second.stamp == stamp) return &kv.second;
+    }
+#endif
+    return nullptr;
+}
+} // namespace
+
+std::shared_ptr<const BinaryView> map_binary_file(const std::string& xclbin_file_name) {
+    struct stat sb;
+    if (stat(xclbin_file_name.c_str(), &sb) != 0) {
+        printf("ERROR: %s xclbin not available please build\n", xclbin_file_name.c_str());
+        exit(EXIT_FAILURE);
+    }
+    FileStamp stamp = file_stamp(sb);
+
+    {
+        std::lock_guard<std::mutex> lock(g_binary_cache_mutex);
+        const BinaryCacheEntry* hit = find_binary(xclbin_file_name, stamp);
+        if (hit != nullptr) {
+            std::cout << "INFO: Reusing mapped " << xclbin_file_name << std::endl;
+            g_binary_cache[xclbin_file_name] = *hit;
+            return hit->view;
+        }
+    }
+
+    // New or changed on disk. Mapping and hashing happen outside the lock,
+    // so workers loading other files are not held up.
+    BinaryCacheEntry entry;
+    entry.stamp = stamp;
+    entry.view = std::make_shared<const BinaryView>(xclbin_file_name);
+    entry.hash = entry.view->hash();
+
+    std::lock_guard<std::mutex> lock(g_binary_cache_mutex);
+    // Another thread mapped it meanwhile
+    const BinaryCacheEntry* hit = find_binary(xclbin_file_name, stamp);
+    if (hit != nullptr) entry.view = hit->view;
+    // A file that was only touched or copied keeps its earlier view
+    auto old = g_binary_cache.find(xclbin_file_name);
+    if (hit == nullptr && old != g_binary_cache.end() && old->second.hash == entry.hash) entry.view = old->second.view;
+    g_binary_cache[xclbin_file_name] = entry;
+    return entry.view;
+}
+
+void clear_binary_cache() {
+    std::lock_guard<std::mutex> lock(g_binary_cache_mutex);
+    g_binary_cache.clear();
+}
+
+namespace {
+const size_t k_page_size = 4096;
+const size_t k_huge_2m = 2UL << 20;
+const size_t k_huge_1g = 1UL << 30;
+
+struct HostBlock {
+    size_t bytes;
+    int numa_node;
+};
+
+struct HostPool {
+    std::mutex mutex;
+    std::map<void*, HostBlock> live;
+    std::map<std::pair<size_t, int>, std::vector<void*> > free_blocks;
+    size_t cached_bytes;
+    size_t max_cached_bytes;
+    int default_node;
+};
+
+HostPool* create_host_pool() {
+    HostPool* pool = new HostPool();
+    pool->cached_bytes = 0;
+    pool->max_cached_bytes = ~size_t(0);
+    pool->default_node = -1;
+#if !defined(_WINDOWS)
+    long pages = sysconf(_SC_PHYS_PAGES);
+    if (pages > 0) pool->max_cached_bytes = (size_t)pages * k_page_size / 2;
+#endif
+    char* node = getenv("XCL_HOST_NUMA_NODE");
+    if (node != nullptr) pool->default_node = atoi(node);
+    return pool;
+}
+
+HostPool& host_pool() {
+    // Never destroyed, vectors with static storage may still free into it
+    static HostPool* pool = create_host_pool();
+    return *pool;
+}
+
+// Small requests share power of two classes, large ones are rounded to 2 MB
+// so at most one 2 MB page is wasted. Sizes that are a whole number of GB
+// still get 1 GB hugepages from host_map.
+size_t host_size_class(size_t bytes) {
+    if (bytes >= k_huge_2m) return (bytes + k_huge_2m - 1) & ~(k_huge_2m - 1);
+    size_t c = k_page_size;
+    while (c < bytes) c <<= 1;
+    return c;
+}
+
+#if !defined(_WINDOWS)
+void* host_map(size_t bytes) {
+#ifdef MAP_HUGETLB
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+    // Explicit hugepages only succeed when the administrator reserved them
+    if (bytes % k_huge_1g == 0) {
+        void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (30 << MAP_HUGE_SHIFT), -1, 0);
+        if (p != MAP_FAILED) return p;
+    }
+    if (bytes % k_huge_2m == 0) {
+        void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (21 << MAP_HUGE_SHIFT), -1, 0);
+        if (p != MAP_FAILED) return p;
+    }
+#endif
+    if (bytes < k_huge_2m) {
+        void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return (p == MAP_FAILED) ? nullptr : p;
+    }
+    // Transparent hugepages need a 2 MB aligned range, over-map and trim
+    size_t span = bytes + k_huge_2m;
+    char* raw = static_cast<char*>(mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (raw == MAP_FAILED) return nullptr;
+    char* p = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(raw) + k_huge_2m - 1) & ~(k_huge_2m - 1));
+    if (p != raw) munmap(raw, p - raw);
+    if (raw + span != p + bytes) munmap(p + bytes, (raw + span) - (p + bytes));
+#ifdef MADV_HUGEPAGE
+    madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+    return p;
+}
+
+void host_bind(void* p, size_t bytes, int numa_node) {
+#ifdef SYS_mbind
+    const int mpol_bind = 2;
+    unsigned long mask[16] = {0};
+    if (numa_node < 0 || numa_node >= (int)(sizeof(mask) * 8)) return;
+    mask[numa_node / (sizeof(unsigned long) * 8)] = 1UL << (numa_node % (sizeof(unsigned long) * 8));
+    if (syscall(SYS_mbind, p, bytes, mpol_bind, mask, sizeof(mask) * 8, 0) != 0) {
+        std::cout << "WARNING: unable to bind host buffer to NUMA node " << numa_node << std::endl;
+    }
+#endif
+}
+#endif
+} // namespace
+
+void* host_alloc(size_t bytes, int numa_node) {
+#if defined(_WINDOWS)
+    void* ptr = _aligned_malloc(bytes, k_page_size);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+#else
+    if (bytes == 0) bytes = 1;
+    HostPool& pool = host_pool();
+    size_t cls = host_size_class(bytes);
+    std::lock_guard<std::mutex> lock(pool.mutex);
+
+    void* ptr = nullptr;
+    auto it = pool.free_blocks.find(std::make_pair(cls, numa_node));
+    if (it != pool.free_blocks.end() && !it->second.empty()) {
+        ptr = it->second.back();
+        it->second.pop_back();
+        pool.cached_bytes -= cls;
+    } else {
+        ptr = host_map(cls);
+        if (ptr == nullptr) throw std::bad_alloc();
+        host_bind(ptr, cls, numa_node);
+    }
+    HostBlock block;
+    block.bytes = cls;
+    block.numa_node = numa_node;
+    pool.live[ptr] = block;
+    return ptr;
+#endif
+}
+
+void host_free(void* ptr) {
+    if (ptr == nullptr) return;
+#if defined(_WINDOWS)
+    _aligned_free(ptr);
+#else
+    HostPool& pool = host_pool();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    auto it = pool.live.find(ptr);
+    if (it == pool.live.end()) {
+        std::cout << "ERROR: host_free() called on a pointer not owned by the pool" << std::endl;
+        return;
+    }
+    HostBlock block = it->second;
+    pool.live.erase(it);
+    if (pool.cached_bytes + block.bytes > pool.max_cached_bytes) {
+        munmap(ptr, block.bytes);
+        return;
+    }
+    pool.free_blocks[std::make_pair(block.bytes, block.numa_node)].push_back(ptr);
+    pool.cached_bytes += block.bytes;
+#endif
+}
+
+void host_pool_trim() {
+#if !defined(_WINDOWS)
+    HostPool& pool = host_pool();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    for (auto& kv : pool.free_blocks) {
+        for (auto p : kv.second) munmap(p, kv.first.first);
+    }
+    pool.free_blocks.clear();
+    pool.cached_bytes = 0;
+#endif
+}
+
+void set_default_numa_node(int numa_node) {
+    HostPool& pool = host_pool();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    pool.default_node = numa_node;
+}
+
+int default_numa_node() {
+    HostPool& pool = host_pool();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    return pool.default_node;
 }
 
 bool is_emulation() {
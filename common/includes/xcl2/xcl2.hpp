@@ -34,6 +34,7 @@
 #include <CL/cl_ext_xilinx.h>
 #include <fstream>
 #include <iostream>
+#include <memory>
 // When creating a buffer with user pointer (CL_MEM_USE_HOST_PTR), under the
 // hood
 // User ptr is used if and only if it is properly aligned (page aligned). When
@@ -86,6 +87,53 @@ struct aligned_allocator {
     }
 };
 
+namespace xcl {
+// Page-aligned host memory served from a process-wide size-class pool.
+// Requests of 2 MB and above are backed by 1 GB or 2 MB hugepages when the
+// system has them reserved, otherwise by transparent hugepages. A numa_node
+// >= 0 binds the pages to that node before they are first touched.
+void* host_alloc(size_t bytes, int numa_node);
+void host_free(void* ptr);
+// Returns all cached blocks to the operating system
+void host_pool_trim();
+// Node used by default constructed pooled_allocator, initialised from the
+// XCL_HOST_NUMA_NODE environment variable (-1, no binding, when unset)
+void set_default_numa_node(int numa_node);
+int default_numa_node();
+}
+
+// Drop-in replacement for aligned_allocator for large, repeatedly allocated
+// buffers. Keeps the page alignment required by CL_MEM_USE_HOST_PTR, but
+// recycles freed blocks instead of returning them to the system, so sweeps
+// reallocating the same sizes do not fault their pages in again.
+template <typename T>
+struct pooled_allocator {
+    using value_type = T;
+
+    int numa_node;
+
+    pooled_allocator() : numa_node(xcl::default_numa_node()) {}
+
+    explicit pooled_allocator(int node) : numa_node(node) {}
+
+    template <typename U>
+    pooled_allocator(const pooled_allocator<U>& other) : numa_node(other.numa_node) {}
+
+    T* allocate(std::size_t num) { return reinterpret_cast<T*>(xcl::host_alloc(num * sizeof(T), numa_node)); }
+    void deallocate(T* p, std::size_t num) { xcl::host_free(p); }
+};
+
+// Any instance can release blocks obtained through another one
+template <typename T, typename U>
+bool operator==(const pooled_allocator<T>& a, const pooled_allocator<U>& b) {
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const pooled_allocator<T>& a, const pooled_allocator<U>& b) {
+    return !(a == b);
+}
+
 namespace xcl {
 std::vector<cl::Device> get_xil_devices();
 std::vector<cl::Device> get_devices(const std::string& vendor_name);
@@ -93,6 +141,69 @@ cl::Device find_device_bdf(const std::vector<cl::Device>& devices, const std::st
 cl_device_id find_device_bdf_c(cl_device_id* devices, const std::string& bdf, cl_uint dev_count);
 std::string convert_size(size_t size);
 std::vector<unsigned char> read_binary_file(const std::string& xclbin_file_name);
+// Read-only view of an xclbin file mapped into the process address space.
+// The mapping is shared through the page cache, so repeated loads of the same
+// file (and children forked after the first load) do not copy the binary.
+class BinaryView {
+   public:
+    explicit BinaryView(const std::string& xclbin_file_name);
+    ~BinaryView();
+    BinaryView(const BinaryView&) = delete;
+    BinaryView& operator=(const BinaryView&) = delete;
+
+    const unsigned char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    const std::string& name() const { return m_name; }
+    // 64-bit FNV-1a hash of the file content, computed on first use
+    uint64_t hash() const;
+
+   private:
+    std::string m_name;
+    const unsigned char* m_data;
+    size_t m_size;
+    mutable uint64_t m_hash;
+    mutable bool m_hashed;
+#if defined(_WINDOWS)
+    std::vector<unsigned char> m_buf;
+#endif
+};
+// Returns a cached view of the xclbin file. Entries are keyed by path and
+// validated against the file inode, size and modification time, so a rebuilt
+// xclbin is mapped again while unchanged files are served from the cache. A
+// file mapped again with the content hash of its earlier mapping keeps the
+// earlier view.
+std::shared_ptr<const BinaryView> map_binary_file(const std::string& xclbin_file_name);
+void clear_binary_cache();
+// A device with its context, queue and program, as returned by program_all().
+// err is CL_SUCCESS when the handles are ready to use.
+struct ProgrammedDevice {
+    cl::Device device;
+    cl::Context context;
+    cl::CommandQueue queue;
+    cl::Program program;
+    std::shared_ptr<const BinaryView> binary;
+    cl_int err;
+    double program_ms;
+};
+// Creates a context, a queue and a program on every device concurrently, so
+// startup is bounded by the slowest device rather than by the sum of them.
+// binaries holds one xclbin per device, or a single xclbin for all of them.
+// The time spent on each device is reported once all devices are done.
+// max_threads = 0 uses one thread per device.
+std::vector<ProgrammedDevice> program_all(const std::vector<cl::Device>& devices,
+                                          const std::vector<std::string>& binaries,
+                                          cl_command_queue_properties queue_props = CL_QUEUE_PROFILING_ENABLE,
+                                          const cl_context_properties* context_props = nullptr,
+                                          unsigned max_threads = 0);
+// Profiling timestamps of a command in ns, read from an event of a queue
+// created with CL_QUEUE_PROFILING_ENABLE
+struct EventTimes {
+    cl_ulong queued;
+    cl_ulong submit;
+    cl_ulong start;
+    cl_ulong end;
+};
+EventTimes get_event_times(const cl::Event& event);
 bool is_emulation();
 bool is_hw_emulation();
 bool is_xpr_device(const char* device_name);
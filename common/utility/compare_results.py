@@ -0,0 +1,96 @@
+#!/usr/bin/env python
+
+#
+# utility that compares two results files written by the performance
+# examples (XCL_RESULTS=<file>, see common/includes/results/results.hpp) and
+# reports the metrics that regressed
+#
+# A metric regressed when its median moved in the worse direction by more
+# than the larger of the relative threshold and sigma times the combined
+# standard deviation of both runs, so metrics that were noisy in either run
+# need a larger change to be flagged. Exits with 1 if any metric regressed.
+#
+# usage: compare_results.py <baseline.json> <new.json> [--threshold 0.05] [--sigma 3] [--strict]
+#
+
+import argparse
+import json
+import math
+import sys
+
+
+def key(metric):
+    params = ", ".join("%s=%s" % (k, v) for k, v in metric["params"].items())
+    return "%s [%s]" % (metric["name"], params) if params else metric["name"]
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    return data, dict((key(m), m) for m in data["metrics"])
+
+
+def compare(base, new, threshold, sigma):
+    b = base["median"]
+    n = new["median"]
+    if b is None or n is None or b == 0:
+        return None, None, "n/a"
+    change = (n - b) / abs(b)
+    noise = sigma * math.sqrt((base["stddev"] or 0) ** 2 + (new["stddev"] or 0) ** 2) / abs(b)
+    limit = max(threshold, noise)
+    worse = -change if base.get("better", "higher") == "higher" else change
+    if worse > limit:
+        status = "REGRESSION"
+    elif worse < -limit:
+        status = "improved"
+    else:
+        status = "same"
+    return change, limit, status
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare two benchmark results files")
+    parser.add_argument("baseline")
+    parser.add_argument("new")
+    parser.add_argument("--threshold", type=float, default=0.05,
+                        help="smallest relative change reported, 0.05 by default")
+    parser.add_argument("--sigma", type=float, default=3,
+                        help="standard deviations a change must exceed, 3 by default")
+    parser.add_argument("--strict", action="store_true",
+                        help="also fail when a metric of the baseline is missing")
+    args = parser.parse_args()
+
+    base_data, base = load(args.baseline)
+    new_data, new = load(args.new)
+    if base_data.get("benchmark") != new_data.get("benchmark"):
+        print("WARNING: comparing %s against %s" % (base_data.get("benchmark"), new_data.get("benchmark")))
+
+    regressions = 0
+    missing = 0
+    print("%-60s %14s %14s %9s %8s  %s" % ("Metric", "Baseline", "New", "Change", "Limit", "Status"))
+    for k, b in base.items():
+        if k not in new:
+            print("%-60s %14s %14s %9s %8s  %s" % (k, b["median"], "-", "", "", "MISSING"))
+            missing += 1
+            continue
+        n = new[k]
+        change, limit, status = compare(b, n, args.threshold, args.sigma)
+        if status == "REGRESSION":
+            regressions += 1
+        unit = " " + b["unit"] if b["unit"] else ""
+        print("%-60s %14s %14s %9s %8s  %s" % (
+            k, "%.6g%s" % (b["median"], unit) if b["median"] is not None else "null",
+            "%.6g%s" % (n["median"], unit) if n["median"] is not None else "null",
+            "%+.1f%%" % (change * 100) if change is not None else "",
+            "%.1f%%" % (limit * 100) if limit is not None else "", status))
+    for k in new:
+        if k not in base:
+            print("%-60s %14s %14s %9s %8s  %s" % (k, "-", new[k]["median"], "", "", "NEW"))
+
+    print("\n%d metrics compared, %d regressions, %d missing" % (len(base), regressions, missing))
+    if regressions or (args.strict and missing):
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
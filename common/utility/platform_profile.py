@@ -0,0 +1,140 @@
+#!/usr/bin/env python
+
+#
+# utility that merges the results files of the bandwidth examples
+# (XCL_RESULTS=<file>, see common/includes/results/results.hpp) of one
+# platform into a platform capability file, used by the platform_profile
+# target of performance/Makefile and read by roofline.py
+#
+# The capability file gives the PCIe host to card, card to host and
+# bidirectional bandwidth (host_global_bandwidth), the bandwidth of every
+# memory bank and of all banks together (kernel_global_bandwidth), the HBM
+# bandwidth of the best PC mapping (hbm_bandwidth), the AXI efficiency by
+# burst size (axi_burst_performance) and the kernel launch latency. Every
+# value is the median of its repeats and every bandwidth is in GB/s of
+# 10^9 bytes, whatever unit the example reports. Sections whose example
+# did not run are left out.
+#
+# usage: platform_profile.py <results.json>... [--platform <name>] [-o platform_profile.json]
+#
+
+import argparse
+import json
+import sys
+
+# Bytes per unit of the bandwidths reported by each example
+UNITS = {
+    ("host_global_bandwidth", "MB/s"): 1024 * 1024,
+    ("kernel_global_bandwidth", "GB/s"): 1024 * 1024 * 1024,
+    ("axi_burst_performance", "GB/s"): 1024 * 1024 * 1024,
+    ("hbm_bandwidth", "GB/s"): 1000 * 1000 * 1000,
+}
+
+
+def gbps(benchmark, metric):
+    return metric["median"] * UNITS[(benchmark, metric["unit"])] / 1e9
+
+
+def metrics(data, name):
+    return [m for m in data["metrics"] if m["name"] == name and m["median"] is not None]
+
+
+def best(data, name):
+    found = metrics(data, name)
+    return max(found, key=lambda m: m["median"]) if found else None
+
+
+def pcie(data):
+    section = {}
+    for key, name in (("h2d", "Host to Card"), ("d2h", "Card to Host"), ("bidirectional", "Bidirectional")):
+        m = best(data, name)
+        if m:
+            section[key + "_gbps"] = round(gbps("host_global_bandwidth", m), 3)
+            section[key + "_buffer_size"] = int(m["params"]["buffer_size"])
+    return section
+
+
+def memory(data):
+    section = {"banks": {}}
+    for m in metrics(data, "Bank Throughput"):
+        section["banks"][m["params"]["bank"]] = round(gbps("kernel_global_bandwidth", m), 3)
+    for key, name in (("read", "Read Throughput"), ("write", "Write Throughput"),
+                      ("aggregate", "Concurrent Read and Write Throughput")):
+        m = best(data, name)
+        if m:
+            section[key + "_gbps"] = round(gbps("kernel_global_bandwidth", m), 3)
+    return section
+
+
+def hbm(data):
+    m = best(data, "Throughput")
+    if not m:
+        return {}
+    mapping = m["params"]["mapping"]
+    units = [{"cu": c["params"]["cu"], "pcs": c["params"]["pcs"], "gbps": round(gbps("hbm_bandwidth", c), 3)}
+             for c in metrics(data, "CU Throughput") if c["params"]["mapping"] == mapping]
+    return {"aggregate_gbps": round(gbps("hbm_bandwidth", m), 3), "mapping": mapping, "compute_units": units}
+
+
+def axi(data):
+    # The best variant of every direction and burst size, over the numbers
+    # of outstanding transactions and buffer sizes that were run
+    rows = {}
+    throughput = dict((json.dumps(m["params"], sort_keys=True), m) for m in metrics(data, "Throughput"))
+    for m in metrics(data, "Efficiency"):
+        p = m["params"]
+        burst_bytes = int(p["width"]) // 8 * int(p["burst_length"])
+        key = (p["direction"], burst_bytes)
+        if key in rows and rows[key]["efficiency"] >= m["median"]:
+            continue
+        t = throughput.get(json.dumps(p, sort_keys=True))
+        rows[key] = {"direction": p["direction"], "burst_bytes": burst_bytes, "width": int(p["width"]),
+                     "burst_length": int(p["burst_length"]), "outstanding": int(p["outstanding"]),
+                     "efficiency": round(m["median"], 1),
+                     "gbps": round(gbps("axi_burst_performance", t), 3) if t else None}
+    return [rows[k] for k in sorted(rows)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Merge benchmark results into a platform capability file")
+    parser.add_argument("results", nargs="+")
+    parser.add_argument("--platform", default="", help="platform name stored in the file")
+    parser.add_argument("-o", "--output", default="platform_profile.json")
+    args = parser.parse_args()
+
+    profile = {"platform": args.platform, "sources": {}}
+    for path in args.results:
+        with open(path) as f:
+            data = json.load(f)
+        benchmark = data.get("benchmark")
+        profile["sources"][benchmark] = path
+        profile.setdefault("host", data.get("host"))
+        profile["timestamp"] = max(profile.get("timestamp", ""), data.get("timestamp", ""))
+        if benchmark == "host_global_bandwidth":
+            profile["pcie"] = pcie(data)
+        elif benchmark == "kernel_global_bandwidth":
+            profile["memory"] = memory(data)
+            m = metrics(data, "Launch Latency")
+            if m:
+                profile["launch_overhead_us"] = round(m[0]["median"], 2)
+        elif benchmark == "hbm_bandwidth":
+            profile["hbm"] = hbm(data)
+        elif benchmark == "axi_burst_performance":
+            profile["axi"] = axi(data)
+        else:
+            print("WARNING: %s holds results of %s, which are not part of a profile" % (path, benchmark))
+
+    if not profile["sources"]:
+        print("Error: no results to profile")
+        sys.exit(1)
+    with open(args.output, "w") as f:
+        json.dump(profile, f, indent=2, sort_keys=True)
+        f.write("\n")
+
+    print("Platform profile written to %s" % args.output)
+    for section in ("pcie", "memory", "hbm", "axi", "launch_overhead_us"):
+        print("  %-20s %s" % (section, "yes" if section in profile else "missing"))
+
+
+if __name__ == "__main__":
+    main()
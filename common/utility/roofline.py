@@ -0,0 +1,140 @@
+#!/usr/bin/env python
+
+#
+# utility that tells whether a kernel is PCIe, memory or compute bound on a
+# platform, from the platform capability file written by
+# platform_profile.py and what one launch of the kernel moves and computes
+#
+# The time of a launch is bounded by the PCIe transfers, by the device
+# memory traffic at the measured bandwidth and by the operations at the
+# compute peak of the kernel. The largest of them names the bottleneck and
+# the others tell how much headroom is left. The launch latency is added to
+# every launch, so small launches can also be launch bound.
+#
+# usage: roofline.py <platform_profile.json> --bytes <n> --ops <n>
+#                    [--h2d <n>] [--d2h <n>] [--peak-ops <ops/s> | --ops-per-cycle <n> --frequency <MHz>]
+#                    [--memory ddr|hbm] [--json]
+#
+
+import argparse
+import json
+import sys
+
+
+def si(value, unit):
+    for scale, prefix in ((1e12, "T"), (1e9, "G"), (1e6, "M"), (1e3, "K")):
+        if abs(value) >= scale:
+            return "%.3g %s%s" % (value / scale, prefix, unit)
+    return "%.3g %s" % (value, unit)
+
+
+def seconds(value):
+    for scale, unit in ((1, "s"), (1e-3, "ms"), (1e-6, "us")):
+        if value >= scale:
+            return "%.3g %s" % (value / scale, unit)
+    return "%.3g ns" % (value * 1e9)
+
+
+def memory_bandwidth(profile, kind):
+    ddr = profile.get("memory", {}).get("aggregate_gbps")
+    hbm = profile.get("hbm", {}).get("aggregate_gbps")
+    if kind == "ddr":
+        return ddr, "DDR"
+    if kind == "hbm":
+        return hbm, "HBM"
+    if hbm and (not ddr or hbm > ddr):
+        return hbm, "HBM"
+    return ddr, "DDR"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Find the bottleneck of a kernel on a profiled platform")
+    parser.add_argument("profile", help="platform capability file of platform_profile.py")
+    parser.add_argument("--bytes", type=float, required=True, help="device memory bytes read and written per launch")
+    parser.add_argument("--ops", type=float, required=True, help="operations per launch")
+    parser.add_argument("--h2d", type=float, default=0, help="bytes copied from the host per launch, 0 by default")
+    parser.add_argument("--d2h", type=float, default=0, help="bytes copied to the host per launch, 0 by default")
+    parser.add_argument("--peak-ops", type=float, help="operations per second the kernel can compute")
+    parser.add_argument("--ops-per-cycle", type=float, help="operations the kernel completes per clock cycle")
+    parser.add_argument("--frequency", type=float, default=300, help="kernel clock in MHz, 300 by default")
+    parser.add_argument("--memory", choices=["ddr", "hbm"], help="memory used by the kernel, the faster by default")
+    parser.add_argument("--json", action="store_true", help="print the analysis as JSON")
+    args = parser.parse_args()
+
+    with open(args.profile) as f:
+        profile = json.load(f)
+
+    peak_ops = args.peak_ops
+    if peak_ops is None and args.ops_per_cycle is not None:
+        peak_ops = args.ops_per_cycle * args.frequency * 1e6
+
+    bounds = {}
+    pcie = profile.get("pcie", {})
+    if args.h2d or args.d2h:
+        # Both directions share the link, so the transfers take at least
+        # as long as each direction alone and as both at the bidirectional
+        # bandwidth. Bandwidths missing from the profile are left out.
+        times = []
+        if args.h2d and pcie.get("h2d_gbps"):
+            times.append(args.h2d / (pcie["h2d_gbps"] * 1e9))
+        if args.d2h and pcie.get("d2h_gbps"):
+            times.append(args.d2h / (pcie["d2h_gbps"] * 1e9))
+        if pcie.get("bidirectional_gbps"):
+            times.append((args.h2d + args.d2h) / (pcie["bidirectional_gbps"] * 1e9))
+        if times:
+            bounds["PCIe"] = max(times)
+        else:
+            sys.stderr.write("WARNING: %s has no PCIe bandwidth, run host_global_bandwidth, "
+                             "the PCIe roof is skipped\n" % args.profile)
+
+    bandwidth, kind = memory_bandwidth(profile, args.memory)
+    if not bandwidth:
+        print("Error: %s has no %s bandwidth" % (args.profile, args.memory.upper() if args.memory else "memory"))
+        sys.exit(1)
+    bounds["memory"] = args.bytes / (bandwidth * 1e9)
+    if peak_ops:
+        bounds["compute"] = args.ops / peak_ops
+
+    launch = profile.get("launch_overhead_us", 0) * 1e-6
+    bottleneck = max(bounds, key=bounds.get)
+    if launch > bounds[bottleneck]:
+        bottleneck = "launch"
+    launch_time = launch + max(bounds.values())
+
+    intensity = args.ops / args.bytes if args.bytes else None
+    result = {
+        "bottleneck": bottleneck,
+        "memory": kind,
+        "memory_gbps": bandwidth,
+        "arithmetic_intensity": intensity,
+        "bounds_s": bounds,
+        "launch_overhead_s": launch,
+        "launch_time_s": launch_time,
+        "attainable_ops": args.ops / launch_time if launch_time else None,
+    }
+    if peak_ops:
+        result["peak_ops"] = peak_ops
+        result["ridge_point"] = peak_ops / (bandwidth * 1e9)
+
+    if args.json:
+        print(json.dumps(result, indent=2, sort_keys=True))
+        return
+
+    print("Platform %s, %s at %.3g GB/s" % (profile.get("platform") or "?", kind, bandwidth))
+    line = "Arithmetic intensity %s" % ("%.3g ops/B" % intensity if intensity is not None else "unbounded")
+    if peak_ops:
+        print("%s, ridge point %.3g ops/B" % (line, result["ridge_point"]))
+    else:
+        print("%s, no compute peak given" % line)
+    top = max(bounds.values()) or 1
+    for name in sorted(bounds, key=bounds.get, reverse=True):
+        print("  %-8s %12s  %5.1f%% of the bottleneck" % (name, seconds(bounds[name]), 100 * bounds[name] / top))
+    if launch:
+        print("  %-8s %12s" % ("launch", seconds(launch)))
+    if result["attainable_ops"] is not None:
+        print("Best case %s per launch, %s" % (seconds(launch_time), si(result["attainable_ops"], "ops/s")))
+    print("The kernel is %s bound" % bottleneck)
+
+
+if __name__ == "__main__":
+    main()
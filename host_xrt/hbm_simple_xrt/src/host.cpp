@@ -75,6 +75,7 @@
  *  same application.
  *
  *  *****************************************************************************************/
+#include "benchmark.hpp"
 #include "cmdlineparser.h"
 #include <iostream>
 #include <cstring>
@@ -88,7 +89,8 @@
 #include <stdlib.h>
 #include <string.h>
 
-double run_krnl(xrtDeviceHandle device, xrt::kernel& krnl, int* bank_assign, unsigned int size) {
+double run_krnl(
+    xrtDeviceHandle device, xrt::kernel& krnl, xcl::Benchmark& bench, int* bank_assign, unsigned int size) {
     size_t vector_size_bytes = sizeof(uint32_t) * size;
 
     std::cout << "Allocate Buffer in Global Memory\n";
@@ -118,15 +120,15 @@ double run_krnl(xrtDeviceHandle device, xrt::kernel& krnl, int* bank_assign, uns
     bo0.sync(XCL_BO_SYNC_BO_TO_DEVICE);
     bo1.sync(XCL_BO_SYNC_BO_TO_DEVICE);
 
-    std::chrono::duration<double> kernel_time(0);
-
+    // The kernel is run until the mean of its run times is stable, it
+    // writes the same output every time
     std::cout << "Execution of the kernel\n";
-    auto kernel_start = std::chrono::high_resolution_clock::now();
-    auto run = krnl(bo0, bo1, bo_out, size);
-    run.wait();
-    auto kernel_end = std::chrono::high_resolution_clock::now();
-
-    kernel_time = std::chrono::duration<double>(kernel_end - kernel_start);
+    auto stats = bench.run([&] {
+        auto run = krnl(bo0, bo1, bo_out, size);
+        run.wait();
+    });
+    std::cout << "Mean of " << stats.samples.size() << " runs, within " << stats.relative_ci() * 100
+              << "% at 95% confidence" << std::endl;
     // Get the output;
     std::cout << "Get the output data from the device" << std::endl;
     bo_out.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
@@ -135,7 +137,7 @@ double run_krnl(xrtDeviceHandle device, xrt::kernel& krnl, int* bank_assign, uns
     if (std::memcmp(bo_out_map, bufReference, size))
         throw std::runtime_error("Value read back does not match reference");
 
-    return kernel_time.count();
+    return stats.mean;
 }
 
 int main(int argc, char* argv[]) {
@@ -163,6 +165,8 @@ int main(int argc, char* argv[]) {
     auto uuid = device.load_xclbin(binaryFile);
 
     auto krnl = xrt::kernel(device, uuid, "krnl_vadd");
+    xcl::Benchmark bench;
+    bench.describe();
 
     unsigned int dataSize = 1024 * 1024;
     double kernel_time_in_sec = 0, result = 0;
@@ -176,7 +180,7 @@ int main(int argc, char* argv[]) {
     std::cout << "input 2 -> bank 0 " << std::endl;
     std::cout << "output  -> bank 0 " << std::endl;
 
-    kernel_time_in_sec = run_krnl(device, krnl, bank_assign, dataSize);
+    kernel_time_in_sec = run_krnl(device, krnl, bench, bank_assign, dataSize);
 
     // Multiplying the actual data size by 3 because three buffers are being used.
     result = 3 * dataSize * sizeof(uint32_t);
@@ -194,7 +198,7 @@ int main(int argc, char* argv[]) {
     std::cout << "input 2 -> bank 2 " << std::endl;
     std::cout << "output  -> bank 3 " << std::endl;
 
-    kernel_time_in_sec = run_krnl(device, krnl, bank_assign, dataSize);
+    kernel_time_in_sec = run_krnl(device, krnl, bench, bank_assign, dataSize);
 
     result = 3 * dataSize * sizeof(uint32_t);
     result /= (1000 * 1000 * 1000); // to GB
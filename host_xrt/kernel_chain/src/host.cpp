@@ -13,6 +13,7 @@
 * License for the specific language governing permissions and limitations
 * under the License.
 */
+#include "benchmark.hpp"
 #include "xcl2.hpp"
 #include <algorithm>
 #include <array>
@@ -22,7 +23,10 @@
 #define MAT_SIZE MAT_DIM* MAT_DIM
 #define NUM_TIMES 10
 ////////////////////UTILITY FUNCTION///////////////
-void print_summary(std::string k1, std::string k2, double t1, double t2, int iterations) {
+void print_summary(
+    std::string k1, std::string k2, const xcl::BenchmarkStats& s1, const xcl::BenchmarkStats& s2, int iterations) {
+    double t1 = s1.mean;
+    double t2 = s2.mean;
     double speedup = t2 / t1;
     std::cout << "|-------------------------+-------------------------|\n"
               << "| Kernel(" << iterations << " iterations)  |    Wall-Clock Time (s)  |\n"
@@ -32,6 +36,8 @@ void print_summary(std::string k1, std::string k2, double t1, double t2, int ite
     std::cout << "|-------------------------+-------------------------|\n";
     std::cout << "| Speedup:                | " << speedup << "\t|\n";
     std::cout << "|-------------------------+-------------------------|\n";
+    std::cout << "Mean of " << s1.samples.size() << " and " << s2.samples.size() << " runs, within "
+              << s1.relative_ci() * 100 << "% and " << s2.relative_ci() * 100 << "% at 95% confidence\n";
     std::cout << "Note: Wall Clock Time is meaningful for real hardware "
                  "execution only, not for emulation.\n";
     std::cout << "Please refer to profile summary for kernel execution time for "
@@ -119,10 +125,10 @@ int main(int argc, char** argv) {
     // platforms and will return list of devices connected to Xilinx platform
     auto devices = xcl::get_xil_devices();
 
-    // read_binary_file() is a utility API which will load the binaryFile
-    // and will return the pointer to file buffer.
-    auto fileBuf = xcl::read_binary_file(binaryFile);
-    cl::Program::Binaries bins{{fileBuf.data(), fileBuf.size()}};
+    // map_binary_file() is a utility API which will map the binaryFile
+    // and will return a view of the file buffer.
+    auto fileBuf = xcl::map_binary_file(binaryFile);
+    cl::Program::Binaries bins{{fileBuf->data(), fileBuf->size()}};
     bool valid_device = false;
     for (unsigned int i = 0; i < devices.size(); i++) {
         auto device = devices[i];
@@ -179,32 +185,37 @@ int main(int argc, char** argv) {
                                                       vector_size_bytes, source_hw_results1[i].data(), &err));
     }
 
-    // Kernel with ap_ctrl_chain
-    auto start_chain = std::chrono::high_resolution_clock::now();
-    for (int i = 0; i < NUM_TIMES; i++) {
-        OCL_CHECK(err, err = krnl_chain_mmult.setArg(0, buffer_in1[i]));
-        OCL_CHECK(err, err = krnl_chain_mmult.setArg(1, buffer_in2[i]));
-        OCL_CHECK(err, err = krnl_chain_mmult.setArg(2, buffer_in3[i]));
-        OCL_CHECK(err, err = krnl_chain_mmult.setArg(3, buffer_in4[i]));
-        OCL_CHECK(err, err = krnl_chain_mmult.setArg(4, buffer_output[i]));
-        OCL_CHECK(err, err = krnl_chain_mmult.setArg(5, MAT_DIM));
+    // The NUM_TIMES launches of each kernel are timed together, repeated
+    // by the benchmark harness until their mean time is stable
+    xcl::Benchmark bench;
+    bench.describe();
 
-        cl::Event event;
-        // Copy input data to device global memory
-        OCL_CHECK(err, err = q.enqueueMigrateMemObjects({buffer_in1[i], buffer_in2[i], buffer_in3[i], buffer_in4[i]},
-                                                        0 /* 0 means from host*/, nullptr, &event));
-        std::vector<cl::Event> waitList;
-        waitList.push_back(event);
-        // Launch the Kernel
-        // For HLS kernels global and local size is always (1,1,1). So, it is
-        // recommended
-        // to always use enqueueTask() for invoking HLS kernel
-        OCL_CHECK(err, err = q.enqueueTask(krnl_chain_mmult, &waitList, nullptr));
-    }
+    // Kernel with ap_ctrl_chain
+    auto stats_chain = bench.run([&] {
+        for (int i = 0; i < NUM_TIMES; i++) {
+            OCL_CHECK(err, err = krnl_chain_mmult.setArg(0, buffer_in1[i]));
+            OCL_CHECK(err, err = krnl_chain_mmult.setArg(1, buffer_in2[i]));
+            OCL_CHECK(err, err = krnl_chain_mmult.setArg(2, buffer_in3[i]));
+            OCL_CHECK(err, err = krnl_chain_mmult.setArg(3, buffer_in4[i]));
+            OCL_CHECK(err, err = krnl_chain_mmult.setArg(4, buffer_output[i]));
+            OCL_CHECK(err, err = krnl_chain_mmult.setArg(5, MAT_DIM));
 
-    OCL_CHECK(err, err = q.finish());
+            cl::Event event;
+            // Copy input data to device global memory
+            OCL_CHECK(err,
+                      err = q.enqueueMigrateMemObjects({buffer_in1[i], buffer_in2[i], buffer_in3[i], buffer_in4[i]},
+                                                       0 /* 0 means from host*/, nullptr, &event));
+            std::vector<cl::Event> waitList;
+            waitList.push_back(event);
+            // Launch the Kernel
+            // For HLS kernels global and local size is always (1,1,1). So, it is
+            // recommended
+            // to always use enqueueTask() for invoking HLS kernel
+            OCL_CHECK(err, err = q.enqueueTask(krnl_chain_mmult, &waitList, nullptr));
+        }
 
-    auto end_chain = std::chrono::high_resolution_clock::now();
+        OCL_CHECK(err, err = q.finish());
+    });
 
     for (int i = 0; i < NUM_TIMES; i++) {
         // Copy Result from Device Global Memory to Host Local Memory
@@ -227,32 +238,33 @@ int main(int argc, char** argv) {
     }
 
     // Kernel without ap_ctrl_chain
-    auto start_hs = std::chrono::high_resolution_clock::now();
-    for (int i = 0; i < NUM_TIMES; i++) {
-        OCL_CHECK(err, err = krnl_simple_mmult.setArg(0, buffer_in5[i]));
-        OCL_CHECK(err, err = krnl_simple_mmult.setArg(1, buffer_in6[i]));
-        OCL_CHECK(err, err = krnl_simple_mmult.setArg(2, buffer_in7[i]));
-        OCL_CHECK(err, err = krnl_simple_mmult.setArg(3, buffer_in8[i]));
-        OCL_CHECK(err, err = krnl_simple_mmult.setArg(4, buffer_output1[i]));
-        OCL_CHECK(err, err = krnl_simple_mmult.setArg(5, MAT_DIM));
+    auto stats_hs = bench.run([&] {
+        for (int i = 0; i < NUM_TIMES; i++) {
+            OCL_CHECK(err, err = krnl_simple_mmult.setArg(0, buffer_in5[i]));
+            OCL_CHECK(err, err = krnl_simple_mmult.setArg(1, buffer_in6[i]));
+            OCL_CHECK(err, err = krnl_simple_mmult.setArg(2, buffer_in7[i]));
+            OCL_CHECK(err, err = krnl_simple_mmult.setArg(3, buffer_in8[i]));
+            OCL_CHECK(err, err = krnl_simple_mmult.setArg(4, buffer_output1[i]));
+            OCL_CHECK(err, err = krnl_simple_mmult.setArg(5, MAT_DIM));
 
-        cl::Event event;
-        // Copy input data to device global memory
-        OCL_CHECK(err, err = q.enqueueMigrateMemObjects({buffer_in5[i], buffer_in6[i], buffer_in7[i], buffer_in8[i]},
-                                                        0 /* 0 means from host*/, nullptr, &event));
+            cl::Event event;
+            // Copy input data to device global memory
+            OCL_CHECK(err,
+                      err = q.enqueueMigrateMemObjects({buffer_in5[i], buffer_in6[i], buffer_in7[i], buffer_in8[i]},
+                                                       0 /* 0 means from host*/, nullptr, &event));
 
-        std::vector<cl::Event> waitList;
-        waitList.push_back(event);
+            std::vector<cl::Event> waitList;
+            waitList.push_back(event);
 
-        // Launch the Kernel
-        // For HLS kernels global and local size is always (1,1,1). So, it is
-        // recommended
-        // to always use enqueueTask() for invoking HLS kernel
-        OCL_CHECK(err, err = q.enqueueTask(krnl_simple_mmult, &waitList, nullptr));
-    }
+            // Launch the Kernel
+            // For HLS kernels global and local size is always (1,1,1). So, it is
+            // recommended
+            // to always use enqueueTask() for invoking HLS kernel
+            OCL_CHECK(err, err = q.enqueueTask(krnl_simple_mmult, &waitList, nullptr));
+        }
 
-    OCL_CHECK(err, err = q.finish());
-    auto end_hs = std::chrono::high_resolution_clock::now();
+        OCL_CHECK(err, err = q.finish());
+    });
 
     for (int i = 0; i < NUM_TIMES; i++) {
         // Copy Result from Device Global Memory to Host Local Memory
@@ -273,9 +285,7 @@ int main(int argc, char** argv) {
         }
     }
 
-    auto elapsed_chain = std::chrono::duration<double>(end_chain - start_chain).count();
-    auto elapsed_hs = std::chrono::duration<double>(end_hs - start_hs).count();
-    print_summary("krnl_chain_mmult", "krnl_simple_mmult", elapsed_chain, elapsed_hs, NUM_TIMES);
+    print_summary("krnl_chain_mmult", "krnl_simple_mmult", stats_chain, stats_hs, NUM_TIMES);
 
     bool test_status = match;
     std::cout << "TEST " << (test_status ? "PASSED" : "FAILED") << std::endl;
@@ -14,6 +14,7 @@
 * under the License.
 */
 
+#include "benchmark.hpp"
 #include "cmdlineparser.h"
 #include <iostream>
 #include <cstring>
@@ -102,20 +103,23 @@ int main(int argc, char** argv) {
     // Get the output;
     std::cout << "Get the output data from the device" << std::endl;
 
+    // The loop of transfers is repeated by the benchmark harness until the
+    // mean loop time is stable
+    xcl::Benchmark bench;
+    bench.describe();
     int loop = 10000;
-    std::chrono::high_resolution_clock::time_point t_start = std::chrono::high_resolution_clock::now();
-    for (int i = 0; i < loop; i++) {
-        // The below line should be uncommented if you are running the design when p2p is not enabled.
-        // out1.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
-        in2.sync(XCL_BO_SYNC_BO_TO_DEVICE);
-    }
-    std::chrono::high_resolution_clock::time_point t_end = std::chrono::high_resolution_clock::now();
+    auto stats = bench.run([&] {
+        for (int i = 0; i < loop; i++) {
+            // The below line should be uncommented if you are running the design when p2p is not enabled.
+            // out1.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
+            in2.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+        }
+    });
     // Calculations
-    unsigned long t_duration = std::chrono::duration_cast<std::chrono::microseconds>(t_end - t_start).count();
-    double secduration = t_duration / (double)1000000;
-    double gbpersec = ((loop * vector_size_bytes) / secduration) / ((double)1024 * 1024 * 1024);
+    double gbpersec = ((loop * vector_size_bytes) / stats.mean) / ((double)1024 * 1024 * 1024);
     std::cout << "Bytes Transfer = " << vector_size_bytes << " Iterations = " << loop
-              << "\nThroughput= " << std::setprecision(2) << std::fixed << gbpersec << "GB/s\n";
+              << " Runs = " << stats.samples.size() << "\nThroughput= " << std::setprecision(2) << std::fixed
+              << gbpersec << "GB/s\n";
 
     // Validate our results
     if (std::memcmp(out1_map, bufReference, DATA_SIZE))
@@ -51,7 +51,7 @@ PACKAGE_OUT = ./package.$(TARGET)
 
 VPP := v++
 VPP_PFLAGS := 
-CMD_ARGS = -x1 $(BUILD_DIR)/test_kernel_maxi_256bit.xclbin -x2 $(BUILD_DIR)/test_kernel_maxi_512bit.xclbin
+CMD_ARGS = -x $(BUILD_DIR)/test_kernel_maxi.xclbin
 
 CXXFLAGS += -I$(XILINX_XRT)/include -I$(XILINX_VIVADO)/include -Wall -O0 -g -std=c++1y
 LDFLAGS += -L$(XILINX_XRT)/lib -pthread -lOpenCL
@@ -64,6 +64,8 @@ PLATFORM_BLOCKLIST += zc vck aws-vu9p-f1 samsung u2_ nodma v70
 CXXFLAGS += -I$(XF_PROJ_ROOT)/common/includes/xcl2
 CXXFLAGS += -I$(XF_PROJ_ROOT)/common/includes/cmdparser
 CXXFLAGS += -I$(XF_PROJ_ROOT)/common/includes/logger
+CXXFLAGS += -I$(XF_PROJ_ROOT)/common/includes/results
+CXXFLAGS += -I$(XF_PROJ_ROOT)/common/includes/benchmark
 HOST_SRCS += $(XF_PROJ_ROOT)/common/includes/xcl2/xcl2.cpp $(XF_PROJ_ROOT)/common/includes/cmdparser/cmdlineparser.cpp $(XF_PROJ_ROOT)/common/includes/logger/logger.cpp ./src/host.cpp 
 # Host compiler global settings
 CXXFLAGS += -fmessage-length=0
@@ -77,20 +79,18 @@ EXECUTABLE = ./axi_burst_performance
 EMCONFIG_DIR = $(TEMP_DIR)
 
 ############################## Declaring Binary Containers ##############################
-BINARY_CONTAINERS += $(BUILD_DIR)/test_kernel_maxi_256bit.xclbin
-BINARY_CONTAINER_test_kernel_maxi_256bit_OBJS += $(TEMP_DIR)/test_kernel_maxi_256bit_1.xo
-BINARY_CONTAINER_test_kernel_maxi_256bit_OBJS += $(TEMP_DIR)/test_kernel_maxi_256bit_2.xo
-BINARY_CONTAINER_test_kernel_maxi_256bit_OBJS += $(TEMP_DIR)/test_kernel_maxi_256bit_3.xo
-BINARY_CONTAINER_test_kernel_maxi_256bit_OBJS += $(TEMP_DIR)/test_kernel_maxi_256bit_4.xo
-BINARY_CONTAINER_test_kernel_maxi_256bit_OBJS += $(TEMP_DIR)/test_kernel_maxi_256bit_5.xo
-BINARY_CONTAINER_test_kernel_maxi_256bit_OBJS += $(TEMP_DIR)/test_kernel_maxi_256bit_6.xo
-BINARY_CONTAINERS += $(BUILD_DIR)/test_kernel_maxi_512bit.xclbin
-BINARY_CONTAINER_test_kernel_maxi_512bit_OBJS += $(TEMP_DIR)/test_kernel_maxi_512bit_1.xo
-BINARY_CONTAINER_test_kernel_maxi_512bit_OBJS += $(TEMP_DIR)/test_kernel_maxi_512bit_2.xo
-BINARY_CONTAINER_test_kernel_maxi_512bit_OBJS += $(TEMP_DIR)/test_kernel_maxi_512bit_3.xo
-BINARY_CONTAINER_test_kernel_maxi_512bit_OBJS += $(TEMP_DIR)/test_kernel_maxi_512bit_4.xo
-BINARY_CONTAINER_test_kernel_maxi_512bit_OBJS += $(TEMP_DIR)/test_kernel_maxi_512bit_5.xo
-BINARY_CONTAINER_test_kernel_maxi_512bit_OBJS += $(TEMP_DIR)/test_kernel_maxi_512bit_6.xo
+# Every combination of data width, burst length and number of outstanding
+# transactions is built from src/test_kernel_maxi.cpp as its own kernel. The
+# host discovers the variants from the xclbin, so the matrix can be changed
+# here or on the make command line.
+MAXI_WIDTHS ?= 256 512
+MAXI_BURST_LENGTHS ?= 4 8 16 32 64
+MAXI_OUTSTANDING ?= 4 8 16 32
+MAXI_VARIANTS := $(foreach w,$(MAXI_WIDTHS),$(foreach bl,$(MAXI_BURST_LENGTHS),$(foreach ot,$(MAXI_OUTSTANDING),$(w)_$(bl)_$(ot))))
+MAXI_KERNEL = test_kernel_maxi_$(word 1,$(subst _, ,$(1)))bit_bl$(word 2,$(subst _, ,$(1)))_ot$(word 3,$(subst _, ,$(1)))
+
+BINARY_CONTAINERS += $(BUILD_DIR)/test_kernel_maxi.xclbin
+BINARY_CONTAINER_test_kernel_maxi_OBJS += $(foreach v,$(MAXI_VARIANTS),$(TEMP_DIR)/$(call MAXI_KERNEL,$(v)).xo)
 
 ############################## Setting Targets ##############################
 CP = cp -rf
@@ -108,51 +108,17 @@ build: check-vitis check-device $(BINARY_CONTAINERS)
 xclbin: build
 
 ############################## Setting Rules for Binary Containers (Building Kernels) ##############################
-$(TEMP_DIR)/test_kernel_maxi_256bit_1.xo: src/test_kernel_maxi_256bit_1.cpp
+define MAXI_KERNEL_RULE
+$(TEMP_DIR)/$(call MAXI_KERNEL,$(1)).xo: src/test_kernel_maxi.cpp src/test_kernel_common.hpp
 	mkdir -p $(TEMP_DIR)
-	$(VPP) -c $(VPP_FLAGS) -t $(TARGET) --platform $(PLATFORM) -k test_kernel_maxi_256bit_1 --temp_dir $(TEMP_DIR)  -I'$(<D)' -o'$@' '$<'
-$(TEMP_DIR)/test_kernel_maxi_256bit_2.xo: src/test_kernel_maxi_256bit_2.cpp
-	mkdir -p $(TEMP_DIR)
-	$(VPP) -c $(VPP_FLAGS) -t $(TARGET) --platform $(PLATFORM) -k test_kernel_maxi_256bit_2 --temp_dir $(TEMP_DIR)  -I'$(<D)' -o'$@' '$<'
-$(TEMP_DIR)/test_kernel_maxi_256bit_3.xo: src/test_kernel_maxi_256bit_3.cpp
-	mkdir -p $(TEMP_DIR)
-	$(VPP) -c $(VPP_FLAGS) -t $(TARGET) --platform $(PLATFORM) -k test_kernel_maxi_256bit_3 --temp_dir $(TEMP_DIR)  -I'$(<D)' -o'$@' '$<'
-$(TEMP_DIR)/test_kernel_maxi_256bit_4.xo: src/test_kernel_maxi_256bit_4.cpp
-	mkdir -p $(TEMP_DIR)
-	$(VPP) -c $(VPP_FLAGS) -t $(TARGET) --platform $(PLATFORM) -k test_kernel_maxi_256bit_4 --temp_dir $(TEMP_DIR)  -I'$(<D)' -o'$@' '$<'
-$(TEMP_DIR)/test_kernel_maxi_256bit_5.xo: src/test_kernel_maxi_256bit_5.cpp
-	mkdir -p $(TEMP_DIR)
-	$(VPP) -c $(VPP_FLAGS) -t $(TARGET) --platform $(PLATFORM) -k test_kernel_maxi_256bit_5 --temp_dir $(TEMP_DIR)  -I'$(<D)' -o'$@' '$<'
-$(TEMP_DIR)/test_kernel_maxi_256bit_6.xo: src/test_kernel_maxi_256bit_6.cpp
-	mkdir -p $(TEMP_DIR)
-	$(VPP) -c $(VPP_FLAGS) -t $(TARGET) --platform $(PLATFORM) -k test_kernel_maxi_256bit_6 --temp_dir $(TEMP_DIR)  -I'$(<D)' -o'$@' '$<'
-$(TEMP_DIR)/test_kernel_maxi_512bit_1.xo: src/test_kernel_maxi_512bit_1.cpp
-	mkdir -p $(TEMP_DIR)
-	$(VPP) -c $(VPP_FLAGS) -t $(TARGET) --platform $(PLATFORM) -k test_kernel_maxi_512bit_1 --temp_dir $(TEMP_DIR)  -I'$(<D)' -o'$@' '$<'
-$(TEMP_DIR)/test_kernel_maxi_512bit_2.xo: src/test_kernel_maxi_512bit_2.cpp
-	mkdir -p $(TEMP_DIR)
-	$(VPP) -c $(VPP_FLAGS) -t $(TARGET) --platform $(PLATFORM) -k test_kernel_maxi_512bit_2 --temp_dir $(TEMP_DIR)  -I'$(<D)' -o'$@' '$<'
-$(TEMP_DIR)/test_kernel_maxi_512bit_3.xo: src/test_kernel_maxi_512bit_3.cpp
-	mkdir -p $(TEMP_DIR)
-	$(VPP) -c $(VPP_FLAGS) -t $(TARGET) --platform $(PLATFORM) -k test_kernel_maxi_512bit_3 --temp_dir $(TEMP_DIR)  -I'$(<D)' -o'$@' '$<'
-$(TEMP_DIR)/test_kernel_maxi_512bit_4.xo: src/test_kernel_maxi_512bit_4.cpp
-	mkdir -p $(TEMP_DIR)
-	$(VPP) -c $(VPP_FLAGS) -t $(TARGET) --platform $(PLATFORM) -k test_kernel_maxi_512bit_4 --temp_dir $(TEMP_DIR)  -I'$(<D)' -o'$@' '$<'
-$(TEMP_DIR)/test_kernel_maxi_512bit_5.xo: src/test_kernel_maxi_512bit_5.cpp
-	mkdir -p $(TEMP_DIR)
-	$(VPP) -c $(VPP_FLAGS) -t $(TARGET) --platform $(PLATFORM) -k test_kernel_maxi_512bit_5 --temp_dir $(TEMP_DIR)  -I'$(<D)' -o'$@' '$<'
-$(TEMP_DIR)/test_kernel_maxi_512bit_6.xo: src/test_kernel_maxi_512bit_6.cpp
-	mkdir -p $(TEMP_DIR)
-	$(VPP) -c $(VPP_FLAGS) -t $(TARGET) --platform $(PLATFORM) -k test_kernel_maxi_512bit_6 --temp_dir $(TEMP_DIR)  -I'$(<D)' -o'$@' '$<'
-$(BUILD_DIR)/test_kernel_maxi_256bit.xclbin: $(BINARY_CONTAINER_test_kernel_maxi_256bit_OBJS)
-	mkdir -p $(BUILD_DIR)
-	$(VPP) -l $(VPP_FLAGS) -t $(TARGET) --platform $(PLATFORM) $(VPP_LDFLAGS) --temp_dir $(TEMP_DIR)  -o'$(BUILD_DIR)/test_kernel_maxi_256bit.link.xclbin' $(+)
-	$(VPP) -p $(BUILD_DIR)/test_kernel_maxi_256bit.link.xclbin $(VPP_FLAGS) -t $(TARGET) --platform $(PLATFORM) --package.out_dir $(PACKAGE_OUT) -o $(BUILD_DIR)/test_kernel_maxi_256bit.xclbin
+	$(VPP) -c $(VPP_FLAGS) -t $(TARGET) --platform $(PLATFORM) -k $(call MAXI_KERNEL,$(1)) -D MAXI_WIDTH=$(word 1,$(subst _, ,$(1))) -D MAXI_BURST_LENGTH=$(word 2,$(subst _, ,$(1))) -D MAXI_OUTSTANDING=$(word 3,$(subst _, ,$(1))) --temp_dir $(TEMP_DIR)  -I'$$(<D)' -o'$$@' '$$<'
+endef
+$(foreach v,$(MAXI_VARIANTS),$(eval $(call MAXI_KERNEL_RULE,$(v))))
 
-$(BUILD_DIR)/test_kernel_maxi_512bit.xclbin: $(BINARY_CONTAINER_test_kernel_maxi_512bit_OBJS)
+$(BUILD_DIR)/test_kernel_maxi.xclbin: $(BINARY_CONTAINER_test_kernel_maxi_OBJS)
 	mkdir -p $(BUILD_DIR)
-	$(VPP) -l $(VPP_FLAGS) $(VPP_LDFLAGS) -t $(TARGET) --platform $(PLATFORM) --temp_dir $(TEMP_DIR)  -o'$(BUILD_DIR)/test_kernel_maxi_512bit.link.xclbin' $(+)
-	$(VPP) -p $(BUILD_DIR)/test_kernel_maxi_512bit.link.xclbin -t $(TARGET) --platform $(PLATFORM) --package.out_dir $(PACKAGE_OUT) -o $(BUILD_DIR)/test_kernel_maxi_512bit.xclbin
+	$(VPP) -l $(VPP_FLAGS) $(VPP_LDFLAGS) -t $(TARGET) --platform $(PLATFORM) --temp_dir $(TEMP_DIR)  -o'$(BUILD_DIR)/test_kernel_maxi.link.xclbin' $(+)
+	$(VPP) -p $(BUILD_DIR)/test_kernel_maxi.link.xclbin $(VPP_FLAGS) -t $(TARGET) --platform $(PLATFORM) --package.out_dir $(PACKAGE_OUT) -o $(BUILD_DIR)/test_kernel_maxi.xclbin
 
 ############################## Setting Rules for Host (Building Host Executable) ##############################
 $(EXECUTABLE): $(HOST_SRCS) | check-xrt
@@ -14,164 +14,383 @@
 * under the License.
 */
 
+#include "benchmark.hpp"
 #include "cmdlineparser.h"
+#include "results.hpp"
 #include "xcl2.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <sstream>
 #include <unistd.h>
 
+// Layout of the perf output of the kernels, must match
+// test_kernel_common.hpp
+#define WINDOW_BUCKETS 32
+#define PERF_CYCLES 0
+#define PERF_ERRORS 1
+#define PERF_BURST_LENGTH 2
+#define PERF_OUTSTANDING 3
+#define PERF_GROUPS 4
+#define PERF_MAX_WINDOW 5
+#define PERF_HISTOGRAM 6
+#define PERF_WORDS (PERF_HISTOGRAM + WINDOW_BUCKETS)
+#define MODE_WINDOW 2
+
+// Burst configuration of a kernel variant, parsed from its name
+// test_kernel_maxi_<width>bit_bl<burst length>_ot<outstanding>
+struct variant_t {
+    int width;
+    uint64_t burst_length;
+    uint64_t outstanding;
+    std::string name;
+};
+
+// Returns the variants of the xclbin, sorted by width, burst length and
+// outstanding transactions
+std::vector<variant_t> discover_variants(const cl::Program& program) {
+    cl_int err;
+    std::vector<variant_t> variants;
+    OCL_CHECK(err, std::string names = program.getInfo<CL_PROGRAM_KERNEL_NAMES>(&err));
+    std::stringstream name_list(names);
+    std::string name;
+    while (std::getline(name_list, name, ';')) {
+        variant_t v;
+        unsigned long bl, ot;
+        if (sscanf(name.c_str(), "test_kernel_maxi_%dbit_bl%lu_ot%lu", &v.width, &bl, &ot) != 3) continue;
+        v.burst_length = bl;
+        v.outstanding = ot;
+        v.name = name;
+        variants.push_back(v);
+    }
+    std::sort(variants.begin(), variants.end(), [](const variant_t& a, const variant_t& b) {
+        if (a.width != b.width) return a.width < b.width;
+        if (a.burst_length != b.burst_length) return a.burst_length < b.burst_length;
+        return a.outstanding < b.outstanding;
+    });
+    return variants;
+}
+
+// Values of the list switch key, or all values present in the variants if
+// the switch is empty
+std::vector<uint64_t> select_values(sda::utils::CmdLineParser& parser,
+                                    const char* key,
+                                    const std::vector<variant_t>& variants,
+                                    uint64_t variant_t::*field) {
+    std::vector<uint64_t> values;
+    if (!parser.value(key).empty()) return parser.value_to_list(key);
+    for (auto& v : variants) values.push_back(v.*field);
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    return values;
+}
+
+// Outstanding window in cycles below which the fraction p of the windows
+// fall. Bucket b of the histogram holds windows of [2^b, 2^(b+1)) cycles,
+// so the upper bound of the bucket is returned, capped by the largest
+// window seen.
+int64_t window_percentile(const int64_t* perf, double p) {
+    int64_t groups = perf[PERF_GROUPS];
+    int64_t max_window = perf[PERF_MAX_WINDOW];
+    int64_t rank = (int64_t)(p * groups);
+    if (rank < 1) rank = 1;
+    int64_t seen = 0;
+    for (int b = 0; b < WINDOW_BUCKETS; b++) {
+        seen += perf[PERF_HISTOGRAM + b];
+        if (seen >= rank) return std::min(((int64_t)2 << b) - 1, max_window);
+    }
+    return max_window;
+}
+
 int main(int argc, char** argv) {
     // Command Line Parser
     sda::utils::CmdLineParser parser;
 
     // Switches
     //**************//"<Full Arg>",  "<Short Arg>", "<Description>", "<Default>"
-    parser.addSwitch("--xclbin_file_testKernel_256", "-x1", "testKernel_256 binary file string", "");
-    parser.addSwitch("--xclbin_file_testKernel_512", "-x2", "testKernel_512 binary file string", "");
+    parser.addSwitch("--xclbin_file", "-x", "test_kernel_maxi binary file string", "");
     parser.addSwitch("--frequency", "-f", "Operating frequency, in MHz", "300");
     parser.addSwitch("--buf_size_mb", "-m", "Test buffer size, in MB", "16");
     parser.addSwitch("--buf_size_kb", "-k", "Test buffer size, in KB", "0");
+    parser.addSwitch("--buf_sizes", "-s", "Test buffer sizes, a list or range such as 1M..64M:x2", "");
+    parser.addSwitch("--widths", "-w", "Data widths to run, all in the xclbin by default", "");
+    parser.addSwitch("--burst_lengths", "-b", "Burst lengths to run, all in the xclbin by default", "");
+    parser.addSwitch("--outstanding", "-o", "Outstanding transactions to run, all in the xclbin by default", "");
+    parser.addSwitch(
+        "--window", "-W", "Report the cycles taken by num_outstanding groups of burst_length beats", "false", true);
     parser.parse(argc, argv);
 
-    std::string xclbinFile1 = parser.value("xclbin_file_testKernel_256");
-    std::string xclbinFile2 = parser.value("xclbin_file_testKernel_512");
-    std::string xclbinFile[] = {xclbinFile1, xclbinFile2};
-    std::string Data_Width[] = {"256", "512"};
+    std::string xclbinFile = parser.value("xclbin_file");
     float frequency = stof(parser.value("frequency"));
     int64_t buf_size_mb = stoi(parser.value("buf_size_mb"));
     int64_t buf_size_kb = stoi(parser.value("buf_size_kb"));
+    bool window = parser.value_to_bool("window");
 
     if (argc < 3) {
         parser.printHelp();
         return EXIT_FAILURE;
     }
 
+    std::vector<uint64_t> buf_sizes;
+    if (!parser.value("buf_sizes").empty()) buf_sizes = parser.value_to_list("buf_sizes");
+    if (!parser.value("buf_sizes").empty() && buf_sizes.empty()) {
+        parser.printHelp();
+        return EXIT_FAILURE;
+    }
+
+    if (xclbinFile.empty()) {
+        std::cerr << "ERROR: xclbin file must be specified with the -x option" << std::endl;
+        parser.printHelp();
+        return EXIT_FAILURE;
+    }
+    if (access(xclbinFile.c_str(), R_OK) != 0) {
+        std::cerr << "ERROR: " << xclbinFile.c_str() << " file not found" << std::endl;
+        parser.printHelp();
+        return EXIT_FAILURE;
+    }
+
     int64_t errors = 0;
+    cl_int err;
+    cl::CommandQueue q;
+    cl::Context context;
+    cl::Program program;
 
-    for (int p = 0; p < 2; p++) {
-        if (xclbinFile[p].empty()) {
-            std::cerr << "ERROR: xclbin file must be specified with the -x" + std::to_string(p) + " option"
-                      << std::endl;
-            parser.printHelp();
-            return EXIT_FAILURE;
-        }
-        if (access(xclbinFile[p].c_str(), R_OK) != 0) {
-            std::cerr << "ERROR: " << xclbinFile[p].c_str() << " file not found" << std::endl;
-            parser.printHelp();
-            return EXIT_FAILURE;
-        }
+    if (xcl::is_emulation()) {
+        buf_size_kb = 16;
+    }
 
-        cl_int err;
-        cl::CommandQueue q;
-        cl::Context context;
-        cl::Kernel krnl[6];
+    if (buf_size_kb == 0) {
+        buf_size_kb = buf_size_mb * 1024;
+    }
+    if (buf_sizes.empty() || xcl::is_emulation()) {
+        buf_sizes = {static_cast<uint64_t>(buf_size_kb * 1024)};
+    }
 
-        if (xcl::is_emulation()) {
-            buf_size_kb = 16;
-        }
+    // Every buffer size and burst configuration runs against one buffer
+    // sized for the largest point of the sweep.
+    int64_t buf_size_bytes = *std::max_element(buf_sizes.begin(), buf_sizes.end()); // buffer size in bytes
+    int64_t kernel_info[PERF_WORDS];
+    int64_t window_info[PERF_WORDS];
 
-        if (buf_size_kb == 0) {
-            buf_size_kb = buf_size_mb * 1024;
-        }
-        int64_t buf_size_bytes = buf_size_kb * 1024; // buffer size in bytes
-        int64_t kernel_info[4];
-
-        std::cout << "\nTest parameters\n";
-        std::cout << " - xclbin file   : " << xclbinFile[p].c_str() << std::endl;
-        std::cout << " - frequency     : " << frequency << " MHz" << std::endl;
-        std::cout << " - buffer size   : " << xcl::convert_size(buf_size_bytes).c_str() << std::endl;
-        std::cout << "\n";
-
-        auto devices = xcl::get_xil_devices();
-        auto device = devices[0];
-        // read_binary_file() is a utility API which will load the binaryFile
-        // and will return the pointer to file buffer.
-        auto fileBuf = xcl::read_binary_file(xclbinFile[p]);
-        cl::Program::Binaries bins{{fileBuf.data(), fileBuf.size()}};
-        bool valid_device = false;
-        for (unsigned int i = 0; i < devices.size(); i++) {
-            auto device = devices[i];
-            // Creating Context and Command Queue for selected Device
-            OCL_CHECK(err, context = cl::Context(device, nullptr, nullptr, nullptr, &err));
-            OCL_CHECK(err, q = cl::CommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE, &err));
-
-            std::cout << "Trying to program device[" << i << "]: " << device.getInfo<CL_DEVICE_NAME>() << std::endl;
-            cl::Program program(context, {device}, bins, nullptr, &err);
-            if (err != CL_SUCCESS) {
-                std::cout << "Failed to program device[" << i << "] with xclbin file!\n";
-            } else {
-                std::cout << "Device[" << i << "]: program successful!\n";
-                for (int i = 0; i < 6; i++) {
-                    std::string krnl_name_full = "test_kernel_maxi_" + Data_Width[p] + "bit_" + std::to_string(i + 1);
-                    OCL_CHECK(err, krnl[i] = cl::Kernel(program, krnl_name_full.c_str(), &err));
-                }
-                valid_device = true;
-                break; // we break because we found a valid device
-            }
-        }
-        if (!valid_device) {
-            std::cerr << "Failed to program any device found, exit!\n";
-            exit(EXIT_FAILURE);
-        }
+    std::cout << "\nTest parameters\n";
+    std::cout << " - xclbin file   : " << xclbinFile.c_str() << std::endl;
+    std::cout << " - frequency     : " << frequency << " MHz" << std::endl;
+    std::cout << " - buffer size   :";
+    for (auto size : buf_sizes) std::cout << " " << xcl::convert_size(size).c_str();
+    std::cout << std::endl;
+    std::cout << "\n";
 
-        // Create the buffers
-        OCL_CHECK(err, cl::Buffer infoBuf(context, CL_MEM_WRITE_ONLY, sizeof(kernel_info), nullptr, &err));
-        OCL_CHECK(err, cl::Buffer dataBuf(context, CL_MEM_READ_WRITE, buf_size_bytes, nullptr, &err));
-        // Pin the buffers to kernel arguments
-        for (int i = 0; i < 6; i++) {
-            OCL_CHECK(err, err = krnl[i].setArg(2, infoBuf));
-            OCL_CHECK(err, err = krnl[i].setArg(3, dataBuf));
-        }
-        // Make buffers resident in the device
-        OCL_CHECK(err, err = q.enqueueMigrateMemObjects({infoBuf, dataBuf}, CL_MIGRATE_MEM_OBJECT_CONTENT_UNDEFINED,
-                                                        nullptr, nullptr));
-        q.finish();
-
-        // Initialize data buffer
-        char* dat = new char[buf_size_bytes];
-        for (int i = 0; i < buf_size_bytes; i++) {
-            dat[i] = 255;
+    auto devices = xcl::get_xil_devices();
+    // map_binary_file() is a utility API which will map the binaryFile
+    // and will return a view of the file buffer.
+    auto fileBuf = xcl::map_binary_file(xclbinFile);
+    cl::Program::Binaries bins{{fileBuf->data(), fileBuf->size()}};
+    bool valid_device = false;
+    for (unsigned int i = 0; i < devices.size(); i++) {
+        auto device = devices[i];
+        // Creating Context and Command Queue for selected Device
+        OCL_CHECK(err, context = cl::Context(device, nullptr, nullptr, nullptr, &err));
+        OCL_CHECK(err, q = cl::CommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE, &err));
+
+        std::cout << "Trying to program device[" << i << "]: " << device.getInfo<CL_DEVICE_NAME>() << std::endl;
+        program = cl::Program(context, {device}, bins, nullptr, &err);
+        if (err != CL_SUCCESS) {
+            std::cout << "Failed to program device[" << i << "] with xclbin file!\n";
+        } else {
+            std::cout << "Device[" << i << "]: program successful!\n";
+            valid_device = true;
+            break; // we break because we found a valid device
         }
-        OCL_CHECK(err, err = q.enqueueWriteBuffer(dataBuf, CL_TRUE, 0, buf_size_bytes, dat, nullptr, nullptr));
+    }
+    if (!valid_device) {
+        std::cerr << "Failed to program any device found, exit!\n";
+        exit(EXIT_FAILURE);
+    }
+
+    // The variants built into the xclbin, restricted to the selected ones
+    std::vector<variant_t> all_variants = discover_variants(program);
+    std::vector<uint64_t> widths;
+    if (!parser.value("widths").empty()) {
+        widths = parser.value_to_list("widths");
+    } else {
+        for (auto& v : all_variants) widths.push_back(v.width);
+    }
+    std::vector<uint64_t> burst_lengths =
+        select_values(parser, "burst_lengths", all_variants, &variant_t::burst_length);
+    std::vector<uint64_t> outstandings = select_values(parser, "outstanding", all_variants, &variant_t::outstanding);
+    std::vector<variant_t> variants;
+    for (auto& v : all_variants) {
+        if (std::count(widths.begin(), widths.end(), (uint64_t)v.width) &&
+            std::count(burst_lengths.begin(), burst_lengths.end(), v.burst_length) &&
+            std::count(outstandings.begin(), outstandings.end(), v.outstanding))
+            variants.push_back(v);
+    }
+    if (variants.empty()) {
+        std::cerr << "ERROR: no test_kernel_maxi variant of the xclbin matches the selection" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "Found " << all_variants.size() << " kernel variants, running " << variants.size() << std::endl;
+
+    // Create the buffers. Every data width gets its own data buffer, the
+    // read variants check the words written by the write variants of their
+    // own width, whose layout differs from that of other widths.
+    OCL_CHECK(err, cl::Buffer infoBuf(context, CL_MEM_WRITE_ONLY, sizeof(kernel_info), nullptr, &err));
+    std::map<int, cl::Buffer> dataBufs;
+    for (auto& v : variants) {
+        if (dataBufs.count(v.width)) continue;
+        OCL_CHECK(err, dataBufs[v.width] = cl::Buffer(context, CL_MEM_READ_WRITE, buf_size_bytes, nullptr, &err));
+    }
 
-        std::string direction[] = {"WRITE", "READ"};
+    // Pin the buffers to kernel arguments
+    std::vector<cl::Kernel> krnl(variants.size());
+    for (size_t i = 0; i < variants.size(); i++) {
+        OCL_CHECK(err, krnl[i] = cl::Kernel(program, variants[i].name.c_str(), &err));
+        OCL_CHECK(err, err = krnl[i].setArg(2, infoBuf));
+        OCL_CHECK(err, err = krnl[i].setArg(3, dataBufs[variants[i].width]));
+    }
+    // Make buffers resident in the device
+    std::vector<cl::Memory> resident = {infoBuf};
+    for (auto& buf : dataBufs) resident.push_back(buf.second);
+    OCL_CHECK(err, err = q.enqueueMigrateMemObjects(resident, CL_MIGRATE_MEM_OBJECT_CONTENT_UNDEFINED, nullptr,
+                                                    nullptr));
+    q.finish();
+
+    // Initialize data buffers
+    char* dat = new char[buf_size_bytes];
+    for (int i = 0; i < buf_size_bytes; i++) {
+        dat[i] = 255;
+    }
+    for (auto& buf : dataBufs) {
+        OCL_CHECK(err, err = q.enqueueWriteBuffer(buf.second, CL_TRUE, 0, buf_size_bytes, dat, nullptr, nullptr));
+    }
 
-        for (int dir = 0; dir < 2; dir++) {
-            std::cout << "\nKernel->AXI Burst " << direction[dir].c_str() << " performance" << std::endl;
-            for (int id = 0; id < 6; id++) {
-                // Run the test
-                OCL_CHECK(err, err = krnl[id].setArg(0, buf_size_bytes));
+    std::string direction[] = {"WRITE", "READ"};
+    bool report = !xcl::is_emulation() or xcl::is_hw_emulation();
+    xcl::Results results("axi_burst_performance");
+    xcl::Benchmark bench;
+    bench.describe();
+
+    for (int dir = 0; dir < 2; dir++) {
+        std::cout << "\nKernel->AXI Burst " << direction[dir].c_str() << " performance" << std::endl;
+
+        // Throughput of every run, by buffer size and variant
+        std::map<std::pair<uint64_t, size_t>, double> throughput;
+        // 99th percentile outstanding window of every run, in ns
+        std::map<std::pair<uint64_t, size_t>, double> p99;
+        for (auto test_size : buf_sizes) {
+            for (size_t id = 0; id < variants.size(); id++) {
+                // Run the test, repeated until the mean of the cycle counts
+                // is stable
+                OCL_CHECK(err, err = krnl[id].setArg(0, (int64_t)test_size));
                 OCL_CHECK(err, err = krnl[id].setArg(1, dir));
-                OCL_CHECK(err, err = q.enqueueTask(krnl[id]));
-                q.finish();
+                auto stats = bench.measure([&] {
+                    OCL_CHECK(err, err = q.enqueueTask(krnl[id]));
+                    q.finish();
+                    OCL_CHECK(err, err = q.enqueueReadBuffer(infoBuf, CL_TRUE, 0, sizeof(kernel_info), kernel_info,
+                                                             nullptr, nullptr));
+                    int64_t duration_cy = kernel_info[PERF_CYCLES];
+                    double duration_ns = (double)(duration_cy * 1000) / frequency;
+                    return duration_ns / (1000 * 1000 * 1000);
+                });
+                // One more run builds the window histogram, apart from
+                // the timed runs so it cannot slow them down
+                if (window) {
+                    OCL_CHECK(err, err = krnl[id].setArg(1, dir | MODE_WINDOW));
+                    OCL_CHECK(err, err = q.enqueueTask(krnl[id]));
+                    q.finish();
+                    OCL_CHECK(err, err = q.enqueueReadBuffer(infoBuf, CL_TRUE, 0, sizeof(window_info),
+                                                             window_info, nullptr, nullptr));
+                }
 
                 // Report results
-                OCL_CHECK(err, err = q.enqueueReadBuffer(infoBuf, CL_TRUE, 0, sizeof(kernel_info), kernel_info, nullptr,
-                                                         nullptr));
-                int64_t duration_cy = kernel_info[0];
-                double duration_ns = (double)(duration_cy * 1000) / frequency;
-                double duration_sec = duration_ns / (1000 * 1000 * 1000);
-                double throughput_bps = buf_size_bytes / duration_sec;
+                double throughput_bps = test_size / stats.mean;
                 double throughput_gbps = throughput_bps / (1024 * 1024 * 1024);
-                errors = kernel_info[1];
-                if (!xcl::is_emulation() or xcl::is_hw_emulation()) {
-                    std::cout << "Data Width = " << Data_Width[p];
-                    std::cout << " burst_length = " << kernel_info[2];
-                    std::cout << " num_outstanding = " << kernel_info[3];
-                    std::cout << " buffer_size = " << xcl::convert_size(buf_size_bytes).c_str();
+                throughput[{test_size, id}] = throughput_gbps;
+                double cy_ns = 1000 / frequency;
+                if (window) p99[{test_size, id}] = window_percentile(window_info, 0.99) * cy_ns;
+                if (kernel_info[PERF_ERRORS]) {
+                    errors += kernel_info[PERF_ERRORS];
+                    std::cerr << "  ERROR: kernel " << variants[id].name << " return code !=0" << std::endl;
+                }
+                xcl::Results::Params params = {{"direction", direction[dir]},
+                                               {"width", variants[id].width},
+                                               {"burst_length", variants[id].burst_length},
+                                               {"outstanding", variants[id].outstanding},
+                                               {"buffer_size", test_size}};
+                if (report) {
+                    // Efficiency is the share of the cycles in which the
+                    // interface moved a full data word
+                    double bytes_per_cycle = variants[id].width / 8.0;
+                    for (auto sample : stats.samples) {
+                        results.add("Throughput", "GB/s", params, test_size / sample / (1024 * 1024 * 1024));
+                        results.add("Efficiency", "%", params,
+                                    100 * test_size / (sample * frequency * 1000 * 1000 * bytes_per_cycle));
+                    }
+                    std::cout << "Data Width = " << variants[id].width;
+                    std::cout << " burst_length = " << kernel_info[PERF_BURST_LENGTH];
+                    std::cout << " num_outstanding = " << kernel_info[PERF_OUTSTANDING];
+                    std::cout << " buffer_size = " << xcl::convert_size(test_size).c_str();
                     std::cout << " | throughput = " << throughput_gbps << " GB/sec" << std::endl;
                 }
-                if (errors) {
-                    std::cerr << "  ERROR: kernel return code !=0" << std::endl;
+                if (report && window) {
+                    std::cout << "  window of " << kernel_info[PERF_OUTSTANDING] << " x "
+                              << kernel_info[PERF_BURST_LENGTH] << " beats over " << window_info[PERF_GROUPS]
+                              << " groups";
+                    std::cout << " | p50 = " << window_percentile(window_info, 0.50) * cy_ns << " ns";
+                    std::cout << " p90 = " << window_percentile(window_info, 0.90) * cy_ns << " ns";
+                    std::cout << " p99 = " << p99[{test_size, id}] << " ns";
+                    std::cout << " max = " << window_info[PERF_MAX_WINDOW] * cy_ns << " ns" << std::endl;
+                    results.add("Outstanding Window p99", "ns", params, p99[{test_size, id}], xcl::Results::LOWER);
                 }
             }
         }
+        if (!report) continue;
 
-        if (xcl::is_emulation() and !xcl::is_hw_emulation()) {
-            std::cout << "\nNot reporting performance throughput for sw_emu as clock signal is not present for time "
-                         "calculation."
-                      << std::endl;
+        // One table per data width and buffer size, burst lengths down and
+        // outstanding transactions across. Combinations not built into the
+        // xclbin are shown as -.
+        std::vector<int> table_widths;
+        for (auto& v : variants) {
+            if (std::find(table_widths.begin(), table_widths.end(), v.width) == table_widths.end())
+                table_widths.push_back(v.width);
         }
+        auto print_table = [&](const std::string& title, int width, uint64_t test_size,
+                               std::map<std::pair<uint64_t, size_t>, double>& values) {
+            std::cout << "\n" << direction[dir] << " " << title << ", data width " << width << ", buffer size "
+                      << xcl::convert_size(test_size) << std::endl;
+            std::cout << std::setw(12) << "BL \\ OT";
+            for (auto ot : outstandings) std::cout << std::setw(9) << ot;
+            std::cout << std::endl << std::fixed << std::setprecision(2);
+            for (auto bl : burst_lengths) {
+                std::cout << std::setw(12) << bl;
+                for (auto ot : outstandings) {
+                    auto it = std::find_if(variants.begin(), variants.end(), [&](const variant_t& v) {
+                        return v.width == width && v.burst_length == bl && v.outstanding == ot;
+                    });
+                    if (it == variants.end())
+                        std::cout << std::setw(9) << "-";
+                    else
+                        std::cout << std::setw(9) << values[{test_size, it - variants.begin()}];
+                }
+                std::cout << std::endl;
+            }
+            std::cout << std::defaultfloat;
+        };
+        for (auto width : table_widths) {
+            for (auto test_size : buf_sizes) {
+                print_table("throughput (GB/sec)", width, test_size, throughput);
+                if (window) print_table("p99 outstanding window (ns)", width, test_size, p99);
+            }
+        }
+    }
+
+    if (xcl::is_emulation() and !xcl::is_hw_emulation()) {
+        std::cout << "\nNot reporting performance throughput for sw_emu as clock signal is not present for time "
+                     "calculation."
+                  << std::endl;
     }
 
+    results.write();
     std::cout << "\nTEST " << ((!errors) ? "PASSED" : "FAILED") << std::endl;
     return ((!errors) ? EXIT_SUCCESS : EXIT_FAILURE);
 }
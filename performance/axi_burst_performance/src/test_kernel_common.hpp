@@ -19,27 +19,61 @@
 #include <cstdint>
 #include <string.h>
 
+// Number of log2 buckets of the outstanding window histogram. Bucket b
+// counts the windows of [2^b, 2^(b+1)) cycles, the last one also counts
+// everything longer.
+#define WINDOW_BUCKETS 32
+
+// Layout of the perf output, in int64_t words
+#define PERF_CYCLES 0
+#define PERF_ERRORS 1
+#define PERF_BURST_LENGTH 2
+#define PERF_OUTSTANDING 3
+#define PERF_GROUPS 4
+#define PERF_MAX_WINDOW 5
+#define PERF_HISTOGRAM 6
+#define PERF_WORDS (PERF_HISTOGRAM + WINDOW_BUCKETS)
+
+// Set in the direction argument to also build the window histogram. The
+// timed runs leave it clear, so their transfer loops send no tokens.
+#define MODE_WINDOW 2
+
+// Token sent to windowProc when the last beat of a group of bl beats has
+// passed the kernel. The stop command is 0.
+#define GROUP_DONE -1
+
 template <typename T>
 
-void writeBuffer(T* mem, int64_t buf_size, int burst_size) {
+void writeBuffer(T* mem, int64_t buf_size, hls::stream<int64_t>& tok, bool window, int burst_size, int bl) {
     buf_size = (buf_size / 1024) * 1024; // Make HLS see that buf_size is a multiple of 1024
+    int beat = 0;
 
 write_buffer:
     for (int64_t i = 0; i < buf_size / burst_size; i++) {
         mem[i] = i;
+        if (window && ++beat == bl) {
+            tok.write(GROUP_DONE); // Timestamp the last beat of the group
+            beat = 0;
+        }
     }
 }
 
 template <typename T>
 
-void readBuffer(T* mem, int64_t buf_size, int64_t& err, int burst_size) {
+void readBuffer(
+    T* mem, int64_t buf_size, int64_t& err, hls::stream<int64_t>& tok, bool window, int burst_size, int bl) {
     int64_t tmp = 0;
+    int beat = 0;
 
     buf_size = (buf_size / 1024) * 1024; // Make HLS see that buf_size is a multiple of 1024
 
 read_buffer:
     for (int64_t i = 0; i < buf_size / burst_size; i++) {
         tmp += (mem[i] != i) ? 1 : 0;
+        if (window && ++beat == bl) {
+            tok.write(GROUP_DONE); // Timestamp the last beat of the group
+            beat = 0;
+        }
     }
 
     err = tmp;
@@ -47,22 +81,95 @@ read_buffer:
 
 // Template to avoid signature conflict in sw_emu
 template <typename T, int DUMMY = 0>
-void testKernelProc(T* mem, int64_t buf_size, int direction, hls::stream<int64_t>& cmd, int burst_size) {
-    if (direction == 0) {
+void testKernelProc(T* mem,
+                    int64_t buf_size,
+                    int direction,
+                    hls::stream<int64_t>& cmd,
+                    hls::stream<int64_t>& tok,
+                    int burst_size,
+                    int bl) {
+    bool window = direction & MODE_WINDOW;
+    if ((direction & 1) == 0) {
         cmd.write(0); // Send a command to start the counter
-        writeBuffer(mem, buf_size, burst_size);
+        tok.write(0);
+        writeBuffer(mem, buf_size, tok, window, burst_size, bl);
         cmd.write(0); // Send a command to stop the counter
+        tok.write(0);
     } else {
         int64_t err;
         cmd.write(0); // Send a command to start the counter
-        readBuffer(mem, buf_size, err, burst_size);
+        tok.write(0);
+        readBuffer(mem, buf_size, err, tok, window, burst_size, bl);
         cmd.write(err); // Send a command to stop the counter
+        tok.write(0);
     }
 }
 
+// Index of the most significant set bit of a window, clamped to the
+// histogram
+inline int windowBucket(int64_t cycles) {
+    int bucket = 0;
+bucket:
+    for (int b = 1; b < WINDOW_BUCKETS; b++) {
+#pragma HLS UNROLL
+        if (cycles >> b) bucket = b;
+    }
+    return bucket;
+}
+
+// Template to avoid signature conflict in sw_emu
+//
+// Outstanding window, run next to the cycle counter so the count loop
+// stays a plain counter. The transfer loop sends a token every bl beats,
+// and for every token this records the cycles since the token ot places
+// earlier, that is the time the last ot x bl beats took to pass the
+// kernel. The pointer based m_axi interface shows neither the requests
+// nor the write responses, and HLS does not promise to split the loop into
+// bursts of exactly bl beats, so a group of bl beats is not a burst and
+// the window is not a burst latency.
+template <int DUMMY = 0>
+void windowProc(hls::stream<int64_t>& tok, hls::stream<int64_t>& win, int ot) {
+    int64_t val;
+    int64_t hist[WINDOW_BUCKETS];
+#pragma HLS ARRAY_PARTITION variable = hist complete
+    // last beat times of the last ot groups
+    int64_t slot[64];
+#pragma HLS ARRAY_PARTITION variable = slot complete
+    int64_t groups = 0;
+    int64_t max_window = 0;
+    int head = 0;
+    int slots = (ot > 64) ? 64 : ot;
+
+init_hist:
+    for (int b = 0; b < WINDOW_BUCKETS; b++) hist[b] = 0;
+init_slot:
+    for (int i = 0; i < 64; i++) slot[i] = 0;
+
+    int64_t cnt = tok.read();
+window:
+    while (true) {
+#pragma HLS PIPELINE II = 1
+        if (tok.read_nb(val)) {
+            if (val != GROUP_DONE) break;
+            int64_t cycles = cnt - slot[head];
+            hist[windowBucket(cycles)]++;
+            if (cycles > max_window) max_window = cycles;
+            slot[head] = cnt;
+            head = (head + 1 == slots) ? 0 : head + 1;
+            groups++;
+        }
+        cnt++;
+    }
+
+    win.write(groups);
+    win.write(max_window);
+send_hist:
+    for (int b = 0; b < WINDOW_BUCKETS; b++) win.write(hist[b]);
+}
+
 // Template to avoid signature conflict in sw_emu
 template <int DUMMY = 0>
-void perfCounterProc(hls::stream<int64_t>& cmd, int64_t* out, int direction, int bl, int ot) {
+void perfCounterProc(hls::stream<int64_t>& cmd, hls::stream<int64_t>& win, int64_t* out, int bl, int ot) {
     int64_t val;
     // wait to receive a value to start counting
     int64_t cnt = cmd.read();
@@ -73,10 +180,12 @@ count:
     }
 
     // write out kernel statistics to global memory
-    int64_t tmp[4];
-    tmp[0] = cnt;
-    tmp[1] = val;
-    tmp[2] = bl;
-    tmp[3] = ot;
-    memcpy(out, tmp, 4 * sizeof(int64_t));
+    int64_t tmp[PERF_WORDS];
+    tmp[PERF_CYCLES] = cnt;
+    tmp[PERF_ERRORS] = val;
+    tmp[PERF_BURST_LENGTH] = bl;
+    tmp[PERF_OUTSTANDING] = ot;
+copy_window:
+    for (int w = PERF_GROUPS; w < PERF_WORDS; w++) tmp[w] = win.read();
+    memcpy(out, tmp, PERF_WORDS * sizeof(int64_t));
 }
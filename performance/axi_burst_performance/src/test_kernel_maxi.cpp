@@ -0,0 +1,63 @@
+/**
+* Copyright (C) 2019-2021 Xilinx, Inc
+*
+* Licensed under the Apache License, Version 2.0 (the "License"). You may
+* not use this file except in compliance with the License. A copy of the
+* License is located at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+* WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+* License for the specific language governing permissions and limitations
+* under the License.
+*/
+
+#include "test_kernel_common.hpp"
+
+// Burst configuration of the kernel. The build compiles this file once for
+// every data width, burst length and number of outstanding transactions of
+// the matrix in makefile_us_alveo.mk, each into a kernel named
+// test_kernel_maxi_<width>bit_bl<burst length>_ot<outstanding>.
+#ifndef MAXI_WIDTH
+#define MAXI_WIDTH 256
+#endif
+#ifndef MAXI_BURST_LENGTH
+#define MAXI_BURST_LENGTH 16
+#endif
+#ifndef MAXI_OUTSTANDING
+#define MAXI_OUTSTANDING 4
+#endif
+
+#define MAXI_KERNEL_NAME_(width, bl, ot) test_kernel_maxi_##width##bit_bl##bl##_ot##ot
+#define MAXI_KERNEL_NAME(width, bl, ot) MAXI_KERNEL_NAME_(width, bl, ot)
+
+// Template to avoid signature conflict in sw_emu
+template <int WIDTH, int BURST_LENGTH, int OUTSTANDING>
+void testKernel(int64_t buf_size, int direction, int64_t* perf, ap_int<WIDTH>* mem) {
+#pragma HLS DATAFLOW
+
+    hls::stream<int64_t> cmd;
+    hls::stream<int64_t> tok;
+    hls::stream<int64_t> win;
+#pragma HLS STREAM variable = tok depth = 64
+#pragma HLS STREAM variable = win depth = 64
+
+    testKernelProc(mem, buf_size, direction, cmd, tok, WIDTH / 8, BURST_LENGTH);
+    windowProc(tok, win, OUTSTANDING);
+    perfCounterProc(cmd, win, perf, BURST_LENGTH, OUTSTANDING);
+}
+
+extern "C" {
+void MAXI_KERNEL_NAME(MAXI_WIDTH, MAXI_BURST_LENGTH, MAXI_OUTSTANDING)(int64_t buf_size,
+                                                                      int direction,
+                                                                      int64_t* perf,
+                                                                      ap_int<MAXI_WIDTH>* mem) {
+#pragma HLS INTERFACE m_axi port = mem bundle = aximm0 num_write_outstanding = MAXI_OUTSTANDING \
+    max_write_burst_length = MAXI_BURST_LENGTH num_read_outstanding = MAXI_OUTSTANDING        \
+    max_read_burst_length = MAXI_BURST_LENGTH offset = slave
+
+    testKernel<MAXI_WIDTH, MAXI_BURST_LENGTH, MAXI_OUTSTANDING>(buf_size, direction, perf, mem);
+}
+}
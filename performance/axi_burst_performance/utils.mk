@@ -72,7 +72,7 @@ ifeq ($(TARGET),$(filter $(TARGET),hw_emu))
 	$(ECHO) 'export XILINX_VITIS=$$PWD' >> run_app.sh
 	$(ECHO) 'export XCL_EMULATION_MODE=$(TARGET)' >> run_app.sh
 endif
-	$(ECHO) './$(EXECUTABLE) -x1 test_kernel_maxi_256bit.xclbin -x2 test_kernel_maxi_512bit.xclbin' >> run_app.sh
+	$(ECHO) './$(EXECUTABLE) -x test_kernel_maxi.xclbin' >> run_app.sh
 	$(ECHO) 'return_code=$$?' >> run_app.sh
 	$(ECHO) 'if [ $$return_code -ne 0 ]; then' >> run_app.sh
 	$(ECHO) 'echo "ERROR: host run failed, RC=$$return_code"' >> run_app.sh
@@ -16,29 +16,44 @@
 
 /********************************************************************************************
 Description:
-    This is a HBM bandwidth example using a pseudo random 1024 bit data access
-pattern to mimic Ethereum Ethash workloads.
-    The design contains 3 compute units of a kernel, reading 1024 bits from a
-pseudo random address in each of 2 pseudo channels and writing the results of
-a simple mathematical operation to a pseudo random address in 2 other pseudo
-channels.
+    This is a HBM bandwidth example using 1024 bit data accesses in a choice of
+access patterns, the pseudo random one mimicking Ethereum Ethash workloads.
+    The design contains one compute unit per access pattern (sequential,
+strided, pseudo random, gather by index table and Zipf skewed), each reading
+1024 bits from the address given by its pattern in each of 2 pseudo channels
+and writing the results of a simple mathematical operation to the same
+address in 2 other pseudo channels. The table driven patterns read their
+table from a fifth pseudo channel.
     To maximize bandwidth the pseudo channels are used in  P2P like
 configuration.
-    The host application allocates buffers in 12  HBM banks and runs the compute
-units concurrently to measure the overall bandwidth between kernel and HBM
-Memory.
+    The host application allocates the buffers of the selected compute units in
+their HBM banks and runs them concurrently to measure the per pattern and the
+overall bandwidth between kernel and HBM Memory.
  ******************************************************************************************/
 
 #include <algorithm>
+#include <cmath>
+#include <iomanip>
 #include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <vector>
 
+#include "benchmark.hpp"
+#include "cmdlineparser.h"
+#include "results.hpp"
+#include "verify.hpp"
 #include "xcl2.hpp"
 
-#define NUM_KERNEL 3
+// Integers in a 1024 bit vector of the kernel
+#define VDATA_SIZE 32
+
+// Data buffers of a compute unit: in1, in2, out_add, out_mul
+#define NUM_ARGS 4
 
 // HBM Pseudo-Channel(PC) requirements
 #define MAX_HBM_PC_COUNT 32
@@ -49,38 +64,155 @@ const int pc[MAX_HBM_PC_COUNT] = {
     PC_NAME(16), PC_NAME(17), PC_NAME(18), PC_NAME(19), PC_NAME(20), PC_NAME(21), PC_NAME(22), PC_NAME(23),
     PC_NAME(24), PC_NAME(25), PC_NAME(26), PC_NAME(27), PC_NAME(28), PC_NAME(29), PC_NAME(30), PC_NAME(31)};
 
-// Function for verifying results
-bool verify(std::vector<uint32_t, aligned_allocator<uint32_t> >& source_sw_add_results,
-            std::vector<uint32_t, aligned_allocator<uint32_t> >& source_sw_mul_results,
-            std::vector<uint32_t, aligned_allocator<uint32_t> >& source_hw_add_results,
-            std::vector<uint32_t, aligned_allocator<uint32_t> >& source_hw_mul_results,
+// Access patterns built into the xclbin, one kernel krnl_vaddmul_<name> each,
+// in the order their ports are given PCs in krnl_vaddmul.cfg. A pattern with
+// a table has it as a fifth buffer after the data buffers, holding one entry
+// per vector. Only the Zipf pattern may leave vectors untouched.
+struct pattern_t {
+    const char* name;
+    size_t table_entry; // bytes, 0 without a table
+    bool full_coverage;
+};
+const pattern_t patterns[] = {{"sequential", 0, true},
+                              {"strided", 0, true},
+                              {"lfsr", 0, true},
+                              {"table", sizeof(uint32_t), true},
+                              {"zipf", sizeof(uint64_t), false}};
+#define NUM_PATTERNS (sizeof(patterns) / sizeof(patterns[0]))
+
+// The U50 stays within its power budget with at most 3 compute units running
+// concurrently, as in the original design of this example
+#define MAX_U50_CU 3
+
+// First PC of the compute unit of pattern p
+int first_pc(size_t p) {
+    int result = 0;
+    for (size_t i = 0; i < p; i++) result += NUM_ARGS + (patterns[i].table_entry ? 1 : 0);
+    return result;
+}
+
+// Function for verifying results, the comparison is split across all cores
+bool verify(std::vector<uint32_t, pooled_allocator<uint32_t> >& source_sw_add_results,
+            std::vector<uint32_t, pooled_allocator<uint32_t> >& source_sw_mul_results,
+            std::vector<uint32_t, pooled_allocator<uint32_t> >& source_hw_add_results,
+            std::vector<uint32_t, pooled_allocator<uint32_t> >& source_hw_mul_results,
             unsigned int size) {
-    bool check = true;
-    for (size_t i = 0; i < size; i++) {
-        if (source_hw_add_results[i] != source_sw_add_results[i]) {
-            std::cout << "Error: Result mismatch in Addition Operation" << std::endl;
-            std::cout << "i = " << i << " CPU result = " << source_sw_add_results[i]
-                      << " Device result = " << source_hw_add_results[i] << std::endl;
-            check = false;
-            break;
+    return xcl::verify("Addition Operation", source_sw_add_results.data(), source_hw_add_results.data(), size) &&
+           xcl::verify("Multiplication Operation", source_sw_mul_results.data(), source_hw_mul_results.data(), size);
+}
+
+// Verifies the results of a pattern which may not touch every vector. The
+// output buffers are zeroed before the run, elements still zero in both
+// outputs are counted in untouched and all others must match.
+bool verify_touched(std::vector<uint32_t, pooled_allocator<uint32_t> >& source_sw_add_results,
+                    std::vector<uint32_t, pooled_allocator<uint32_t> >& source_sw_mul_results,
+                    std::vector<uint32_t, pooled_allocator<uint32_t> >& source_hw_add_results,
+                    std::vector<uint32_t, pooled_allocator<uint32_t> >& source_hw_mul_results,
+                    unsigned int size,
+                    size_t& untouched) {
+    const size_t grain = 1 << 20;
+    size_t num_chunks = (size + grain - 1) / grain;
+    std::vector<size_t> chunk_untouched(num_chunks, 0);
+    std::vector<size_t> chunk_mismatch(num_chunks, size);
+    xcl::parallel_for(size, [&](size_t begin, size_t end) {
+        size_t chunk = begin / grain;
+        for (size_t i = begin; i < end; i++) {
+            if (source_hw_add_results[i] == 0 && source_hw_mul_results[i] == 0) {
+                chunk_untouched[chunk]++;
+            } else if (source_hw_add_results[i] != source_sw_add_results[i] ||
+                       source_hw_mul_results[i] != source_sw_mul_results[i]) {
+                chunk_mismatch[chunk] = i;
+                break;
+            }
         }
-        if (source_hw_mul_results[i] != source_sw_mul_results[i]) {
-            std::cout << "Error: Result mismatch in Multiplication Operation" << std::endl;
-            std::cout << "i = " << i << " CPU result = " << source_sw_mul_results[i]
-                      << " Device result = " << source_hw_mul_results[i] << std::endl;
-            check = false;
-            break;
+    }, grain);
+
+    untouched = std::accumulate(chunk_untouched.begin(), chunk_untouched.end(), (size_t)0);
+    size_t i = *std::min_element(chunk_mismatch.begin(), chunk_mismatch.end());
+    if (i == size) return true;
+    std::cout << "Error: Result mismatch in Addition or Multiplication Operation" << std::endl;
+    std::cout << "i = " << i << " CPU result = " << source_sw_add_results[i] << ", " << source_sw_mul_results[i]
+              << " Device result = " << source_hw_add_results[i] << ", " << source_hw_mul_results[i] << std::endl;
+    return false;
+}
+
+// Builds the alias table of a Zipf distribution with exponent s over vSize
+// vectors, using Vose's method. Ranks are shuffled so the popular vectors are
+// spread over the buffer. Every entry holds the probability of keeping its
+// own vector scaled to 2^32 in the low word and the alternative vector in the
+// high word.
+void build_zipf_table(std::vector<uint64_t, pooled_allocator<uint64_t> >& table,
+                      unsigned int vSize,
+                      double s,
+                      std::mt19937& rng) {
+    std::vector<unsigned int> rank(vSize);
+    std::iota(rank.begin(), rank.end(), 0);
+    std::shuffle(rank.begin(), rank.end(), rng);
+
+    std::vector<double> prob(vSize);
+    double sum = 0;
+    for (unsigned int i = 0; i < vSize; i++) sum += (prob[i] = 1.0 / pow(rank[i] + 1, s));
+
+    std::vector<unsigned int> small, large;
+    for (unsigned int i = 0; i < vSize; i++) {
+        prob[i] = prob[i] * vSize / sum;
+        (prob[i] < 1.0 ? small : large).push_back(i);
+    }
+
+    table.resize(vSize);
+    while (!small.empty() && !large.empty()) {
+        unsigned int l = small.back();
+        unsigned int g = large.back();
+        small.pop_back();
+        table[l] = ((uint64_t)g << 32) | (uint64_t)(prob[l] * 4294967296.0);
+        prob[g] -= 1.0 - prob[l];
+        if (prob[g] < 1.0) {
+            large.pop_back();
+            small.push_back(g);
         }
     }
-    return check;
+    // What is left keeps its own vector, up to rounding
+    for (auto i : small) table[i] = ((uint64_t)i << 32) | 0xffffffff;
+    for (auto i : large) table[i] = ((uint64_t)i << 32) | 0xffffffff;
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cout << "Usage: " << argv[0] << "<XCLBIN> \n";
+    if (argc < 2) {
+        std::cout << "Usage: " << argv[0] << " <XCLBIN> [-p <patterns>] [-s <stride>] [-z <zipf exponent>]\n";
         return -1;
     }
 
+    // Optional switches follow the xclbin file
+    sda::utils::CmdLineParser parser;
+    parser.addSwitch("--patterns", "-p", "access patterns to run, out of sequential,strided,lfsr,table,zipf",
+                     "sequential,lfsr,zipf");
+    parser.addSwitch("--stride", "-s", "stride of the strided pattern in 1024 bit vectors, odd", "17");
+    parser.addSwitch("--zipf", "-z", "exponent of the Zipf pattern", "0.99");
+    if (parser.parse(argc - 1, argv + 1) < 0) {
+        return EXIT_FAILURE;
+    }
+
+    // Every selected pattern runs on its own compute unit
+    std::vector<size_t> selected;
+    std::stringstream pattern_list(parser.value("patterns"));
+    std::string pattern_name;
+    while (std::getline(pattern_list, pattern_name, ',')) {
+        size_t p = 0;
+        while (p < NUM_PATTERNS && pattern_name != patterns[p].name) p++;
+        if (p == NUM_PATTERNS || std::find(selected.begin(), selected.end(), p) != selected.end()) {
+            std::cout << "Error: Unknown or repeated access pattern " << pattern_name << std::endl;
+            return EXIT_FAILURE;
+        }
+        selected.push_back(p);
+    }
+    unsigned int stride = parser.value_to_int("stride");
+    double zipf_s = atof(parser.value("zipf").c_str());
+    if (selected.empty() || stride % 2 == 0 || zipf_s < 0) {
+        parser.printHelp();
+        return EXIT_FAILURE;
+    }
+    size_t num_cu = selected.size();
+
     unsigned int dataSize = 64 * 1024 * 1024; // taking maximum possible data size value for an HBM bank
     unsigned int num_times = 1024;            // num_times specify, number of times a kernel
                                               // will execute the same operation. This is
@@ -93,22 +225,22 @@ int main(int argc, char* argv[]) {
         dataSize = 1024;
         num_times = 64;
     }
+    unsigned int vSize = dataSize / VDATA_SIZE;
 
     std::string binaryFile = argv[1];
     cl_int err;
     cl::CommandQueue q;
-    std::string krnl_name = "krnl_vaddmul";
-    std::vector<cl::Kernel> krnls(NUM_KERNEL);
+    std::vector<cl::Kernel> krnls(num_cu);
     cl::Context context;
-    std::vector<uint32_t, aligned_allocator<uint32_t> > source_in1(dataSize);
-    std::vector<uint32_t, aligned_allocator<uint32_t> > source_in2(dataSize);
-    std::vector<uint32_t, aligned_allocator<uint32_t> > source_sw_add_results(dataSize);
-    std::vector<uint32_t, aligned_allocator<uint32_t> > source_sw_mul_results(dataSize);
+    std::vector<uint32_t, pooled_allocator<uint32_t> > source_in1(dataSize);
+    std::vector<uint32_t, pooled_allocator<uint32_t> > source_in2(dataSize);
+    std::vector<uint32_t, pooled_allocator<uint32_t> > source_sw_add_results(dataSize);
+    std::vector<uint32_t, pooled_allocator<uint32_t> > source_sw_mul_results(dataSize);
 
-    std::vector<uint32_t, aligned_allocator<uint32_t> > source_hw_add_results[NUM_KERNEL];
-    std::vector<uint32_t, aligned_allocator<uint32_t> > source_hw_mul_results[NUM_KERNEL];
+    std::vector<std::vector<uint32_t, pooled_allocator<uint32_t> > > source_hw_add_results(num_cu);
+    std::vector<std::vector<uint32_t, pooled_allocator<uint32_t> > > source_hw_mul_results(num_cu);
 
-    for (int i = 0; i < NUM_KERNEL; i++) {
+    for (size_t i = 0; i < num_cu; i++) {
         source_hw_add_results[i].resize(dataSize);
         source_hw_mul_results[i].resize(dataSize);
     }
@@ -116,21 +248,32 @@ int main(int argc, char* argv[]) {
     // Create the test data
     std::generate(source_in1.begin(), source_in1.end(), std::rand);
     std::generate(source_in2.begin(), source_in2.end(), std::rand);
-    for (size_t i = 0; i < dataSize; i++) {
-        source_sw_add_results[i] = source_in1[i] + source_in2[i];
-        source_sw_mul_results[i] = source_in1[i] * source_in2[i];
-    }
+    xcl::parallel_for(dataSize, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            source_sw_add_results[i] = source_in1[i] + source_in2[i];
+            source_sw_mul_results[i] = source_in1[i] * source_in2[i];
+        }
+    });
+
+    // Pattern data: a random permutation of the vectors for the table pattern
+    // and the alias table of the Zipf pattern
+    std::mt19937 rng(16807);
+    std::vector<uint32_t, pooled_allocator<uint32_t> > index_table(vSize);
+    std::iota(index_table.begin(), index_table.end(), 0);
+    std::shuffle(index_table.begin(), index_table.end(), rng);
+    std::vector<uint64_t, pooled_allocator<uint64_t> > alias_table;
+    build_zipf_table(alias_table, vSize, zipf_s, rng);
 
     // OPENCL HOST CODE AREA START
     // The get_xil_devices will return vector of Xilinx Devices
     auto devices = xcl::get_xil_devices();
 
-    // read_binary_file() command will find the OpenCL binary file created using
+    // map_binary_file() command will find the OpenCL binary file created using
     // the
-    // V++ compiler load into OpenCL Binary and return pointer to file buffer.
-    auto fileBuf = xcl::read_binary_file(binaryFile);
+    // V++ compiler map it into memory and return a view of the file buffer.
+    auto fileBuf = xcl::map_binary_file(binaryFile);
 
-    cl::Program::Binaries bins{{fileBuf.data(), fileBuf.size()}};
+    cl::Program::Binaries bins{{fileBuf->data(), fileBuf->size()}};
     bool valid_device = false;
     for (unsigned int i = 0; i < devices.size(); i++) {
         auto device = devices[i];
@@ -145,11 +288,16 @@ int main(int argc, char* argv[]) {
             std::cout << "Failed to program device[" << i << "] with xclbin file!\n";
         } else {
             std::cout << "Device[" << i << "]: program successful!\n";
+            if (device.getInfo<CL_DEVICE_NAME>().find("u50") != std::string::npos && num_cu > MAX_U50_CU) {
+                std::cout << "Error: At most " << MAX_U50_CU << " access patterns can run concurrently on "
+                          << device.getInfo<CL_DEVICE_NAME>() << ", select fewer with -p\n";
+                exit(EXIT_FAILURE);
+            }
             // Creating Kernel object using Compute unit names
 
-            for (int i = 0; i < NUM_KERNEL; i++) {
-                std::string cu_id = std::to_string(i + 1);
-                std::string krnl_name_full = krnl_name + ":{" + "krnl_vaddmul_" + cu_id + "}";
+            for (size_t i = 0; i < num_cu; i++) {
+                std::string krnl_name = std::string("krnl_vaddmul_") + patterns[selected[i]].name;
+                std::string krnl_name_full = krnl_name + ":{" + krnl_name + "_1}";
 
                 std::cout << "Creating a kernel [" << krnl_name_full.c_str() << "] for CU(" << i + 1 << ")\n";
 
@@ -169,41 +317,50 @@ int main(int argc, char* argv[]) {
         exit(EXIT_FAILURE);
     }
 
-    std::vector<cl_mem_ext_ptr_t> inBufExt1(NUM_KERNEL);
-    std::vector<cl_mem_ext_ptr_t> inBufExt2(NUM_KERNEL);
-    std::vector<cl_mem_ext_ptr_t> outAddBufExt(NUM_KERNEL);
-    std::vector<cl_mem_ext_ptr_t> outMulBufExt(NUM_KERNEL);
+    std::vector<cl_mem_ext_ptr_t> inBufExt1(num_cu);
+    std::vector<cl_mem_ext_ptr_t> inBufExt2(num_cu);
+    std::vector<cl_mem_ext_ptr_t> outAddBufExt(num_cu);
+    std::vector<cl_mem_ext_ptr_t> outMulBufExt(num_cu);
+    std::vector<cl_mem_ext_ptr_t> tableBufExt(num_cu);
 
-    std::vector<cl::Buffer> buffer_input1(NUM_KERNEL);
-    std::vector<cl::Buffer> buffer_input2(NUM_KERNEL);
-    std::vector<cl::Buffer> buffer_output_add(NUM_KERNEL);
-    std::vector<cl::Buffer> buffer_output_mul(NUM_KERNEL);
+    std::vector<cl::Buffer> buffer_input1(num_cu);
+    std::vector<cl::Buffer> buffer_input2(num_cu);
+    std::vector<cl::Buffer> buffer_output_add(num_cu);
+    std::vector<cl::Buffer> buffer_output_mul(num_cu);
+    std::vector<cl::Buffer> buffer_table(num_cu);
 
     // For Allocating Buffer to specific Global Memory PC, user has to use
     // cl_mem_ext_ptr_t
     // and provide the PC
-    for (int i = 0; i < NUM_KERNEL; i++) {
+    for (size_t i = 0; i < num_cu; i++) {
+        int cu_pc = first_pc(selected[i]);
+
         inBufExt1[i].obj = source_in1.data();
         inBufExt1[i].param = 0;
-        inBufExt1[i].flags = pc[i * 4];
+        inBufExt1[i].flags = pc[cu_pc];
 
         inBufExt2[i].obj = source_in2.data();
         inBufExt2[i].param = 0;
-        inBufExt2[i].flags = pc[(i * 4) + 1];
+        inBufExt2[i].flags = pc[cu_pc + 1];
 
         outAddBufExt[i].obj = source_hw_add_results[i].data();
         outAddBufExt[i].param = 0;
-        outAddBufExt[i].flags = pc[(i * 4) + 2];
+        outAddBufExt[i].flags = pc[cu_pc + 2];
 
         outMulBufExt[i].obj = source_hw_mul_results[i].data();
         outMulBufExt[i].param = 0;
-        outMulBufExt[i].flags = pc[(i * 4) + 3];
+        outMulBufExt[i].flags = pc[cu_pc + 3];
+
+        bool zipf = patterns[selected[i]].table_entry == sizeof(uint64_t);
+        tableBufExt[i].obj = zipf ? (void*)alias_table.data() : (void*)index_table.data();
+        tableBufExt[i].param = 0;
+        tableBufExt[i].flags = pc[cu_pc + 4];
     }
 
     // These commands will allocate memory on the FPGA. The cl::Buffer objects can
     // be used to reference the memory locations on the device.
     // Creating Buffers
-    for (int i = 0; i < NUM_KERNEL; i++) {
+    for (size_t i = 0; i < num_cu; i++) {
         OCL_CHECK(err,
                   buffer_input1[i] = cl::Buffer(context, CL_MEM_READ_ONLY | CL_MEM_EXT_PTR_XILINX | CL_MEM_USE_HOST_PTR,
                                                 sizeof(uint32_t) * dataSize, &inBufExt1[i], &err));
@@ -216,42 +373,73 @@ int main(int argc, char* argv[]) {
         OCL_CHECK(err, buffer_output_mul[i] =
                            cl::Buffer(context, CL_MEM_WRITE_ONLY | CL_MEM_EXT_PTR_XILINX | CL_MEM_USE_HOST_PTR,
                                       sizeof(uint32_t) * dataSize, &outMulBufExt[i], &err));
+        if (patterns[selected[i]].table_entry) {
+            size_t table_size = patterns[selected[i]].table_entry * vSize;
+            OCL_CHECK(err, buffer_table[i] = cl::Buffer(context,
+                                                        CL_MEM_READ_ONLY | CL_MEM_EXT_PTR_XILINX | CL_MEM_USE_HOST_PTR,
+                                                        table_size, &tableBufExt[i], &err));
+        }
     }
 
-    // Copy input data to Device Global Memory
-    for (int i = 0; i < NUM_KERNEL; i++) {
-        OCL_CHECK(err,
-                  err = q.enqueueMigrateMemObjects({buffer_input1[i], buffer_input2[i]}, 0 /* 0 means from host*/));
-    }
-    q.finish();
-
-    double kernel_time_in_sec = 0, result = 0;
-
-    std::chrono::duration<double> kernel_time(0);
-
-    auto kernel_start = std::chrono::high_resolution_clock::now();
-    for (int i = 0; i < NUM_KERNEL; i++) {
-        // Setting the k_vadd Arguments
-        OCL_CHECK(err, err = krnls[i].setArg(0, buffer_input1[i]));
-        OCL_CHECK(err, err = krnls[i].setArg(1, buffer_input2[i]));
-        OCL_CHECK(err, err = krnls[i].setArg(2, buffer_output_add[i]));
-        OCL_CHECK(err, err = krnls[i].setArg(3, buffer_output_mul[i]));
-        OCL_CHECK(err, err = krnls[i].setArg(4, dataSize));
-        OCL_CHECK(err, err = krnls[i].setArg(5, num_times));
-
-        // Invoking the kernel
-        OCL_CHECK(err, err = q.enqueueTask(krnls[i]));
+    // Copy input data and tables to Device Global Memory. The zeroed outputs
+    // are copied as well, so vectors a pattern does not touch can be told
+    // apart.
+    for (size_t i = 0; i < num_cu; i++) {
+        std::vector<cl::Memory> buffers = {buffer_input1[i], buffer_input2[i], buffer_output_add[i],
+                                           buffer_output_mul[i]};
+        if (patterns[selected[i]].table_entry) buffers.push_back(buffer_table[i]);
+        OCL_CHECK(err, err = q.enqueueMigrateMemObjects(buffers, 0 /* 0 means from host*/));
     }
     q.finish();
-    auto kernel_end = std::chrono::high_resolution_clock::now();
 
-    kernel_time = std::chrono::duration<double>(kernel_end - kernel_start);
+    double result = 0;
+
+    // Every task records an event, the device timestamps of the events give
+    // the run time of each compute unit and their true overlap. The launch is
+    // repeated by the benchmark harness, each one gives a sample from the
+    // first start to the last end, and the timeline is the last launch's.
+    xcl::Benchmark bench;
+    bench.describe();
+    std::vector<cl::Event> events(num_cu);
+    std::vector<xcl::EventTimes> times(num_cu);
+    double launch_overhead = 0;
+    auto stats = bench.measure([&] {
+        auto launch_start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < num_cu; i++) {
+            const pattern_t& pattern = patterns[selected[i]];
+            unsigned int param = std::string(pattern.name) == "strided" ? stride : 0;
+            int arg = 0;
+
+            // Setting the k_vadd Arguments
+            OCL_CHECK(err, err = krnls[i].setArg(arg++, buffer_input1[i]));
+            OCL_CHECK(err, err = krnls[i].setArg(arg++, buffer_input2[i]));
+            OCL_CHECK(err, err = krnls[i].setArg(arg++, buffer_output_add[i]));
+            OCL_CHECK(err, err = krnls[i].setArg(arg++, buffer_output_mul[i]));
+            if (pattern.table_entry) {
+                OCL_CHECK(err, err = krnls[i].setArg(arg++, buffer_table[i]));
+            }
+            OCL_CHECK(err, err = krnls[i].setArg(arg++, dataSize));
+            OCL_CHECK(err, err = krnls[i].setArg(arg++, num_times));
+            OCL_CHECK(err, err = krnls[i].setArg(arg++, param));
 
-    kernel_time_in_sec = kernel_time.count();
-    kernel_time_in_sec /= NUM_KERNEL;
+            // Invoking the kernel
+            OCL_CHECK(err, err = q.enqueueTask(krnls[i], nullptr, &events[i]));
+        }
+        auto launch_end = std::chrono::high_resolution_clock::now();
+        q.finish();
+
+        launch_overhead = std::chrono::duration<double>(launch_end - launch_start).count();
+        cl_ulong window_start = 0, window_end = 0;
+        for (size_t i = 0; i < num_cu; i++) {
+            times[i] = xcl::get_event_times(events[i]);
+            window_start = (i == 0) ? times[i].start : std::min(window_start, times[i].start);
+            window_end = std::max(window_end, times[i].end);
+        }
+        return (window_end - window_start) / 1e9;
+    });
 
     // Copy Result from Device Global Memory to Host Local Memory
-    for (int i = 0; i < NUM_KERNEL; i++) {
+    for (size_t i = 0; i < num_cu; i++) {
         OCL_CHECK(err, err = q.enqueueMigrateMemObjects({buffer_output_add[i], buffer_output_mul[i]},
                                                         CL_MIGRATE_MEM_OBJECT_HOST));
     }
@@ -259,9 +447,18 @@ int main(int argc, char* argv[]) {
 
     bool match = true;
 
-    for (int i = 0; i < NUM_KERNEL; i++) {
-        match = verify(source_sw_add_results, source_sw_mul_results, source_hw_add_results[i], source_hw_mul_results[i],
-                       dataSize);
+    for (size_t i = 0; i < num_cu; i++) {
+        const pattern_t& pattern = patterns[selected[i]];
+        if (pattern.full_coverage) {
+            match = verify(source_sw_add_results, source_sw_mul_results, source_hw_add_results[i],
+                           source_hw_mul_results[i], dataSize);
+        } else {
+            size_t untouched = 0;
+            match = verify_touched(source_sw_add_results, source_sw_mul_results, source_hw_add_results[i],
+                                   source_hw_mul_results[i], dataSize, untouched);
+            std::cout << "CU(" << i + 1 << ") " << pattern.name << " left " << untouched / VDATA_SIZE << " of "
+                      << vSize << " vectors untouched" << std::endl;
+        }
         if (!match) {
             std::cerr << "TEST FAILED" << std::endl;
             return EXIT_FAILURE;
@@ -269,15 +466,53 @@ int main(int argc, char* argv[]) {
     }
 
     // Multiplying the actual data size by 4 because four buffers are being
-    // used.
-    result = 4 * (float)dataSize * num_times * sizeof(uint32_t);
-    result /= 1000;               // to KB
-    result /= 1000;               // to MB
-    result /= 1000;               // to GB
-    result /= kernel_time_in_sec; // to GBps
+    // used. Table reads are not counted.
+    double cu_bytes = 4 * (double)dataSize * num_times * sizeof(uint32_t);
+    cl_ulong first_queued = times[0].queued, first_start = times[0].start, last_start = times[0].start;
+    cl_ulong first_end = times[0].end, last_end = times[0].end;
+    for (auto& t : times) {
+        first_queued = std::min(first_queued, t.queued);
+        first_start = std::min(first_start, t.start);
+        last_start = std::max(last_start, t.start);
+        first_end = std::min(first_end, t.end);
+        last_end = std::max(last_end, t.end);
+    }
+
+    // Per compute unit timeline in us from the first queued task, and its
+    // bandwidth over its own run time (bytes per ns is GB/s)
+    xcl::Results results("hbm_bandwidth_pseudo_random");
+    std::cout << std::fixed << std::setprecision(1);
+    for (size_t i = 0; i < num_cu; i++) {
+        const pattern_t& pattern = patterns[selected[i]];
+        std::string pattern_str = pattern.name;
+        if (pattern_str == "strided") pattern_str += " " + std::to_string(stride);
+        if (pattern_str == "zipf") pattern_str += " " + parser.value("zipf");
+
+        std::cout << "CU(" << i + 1 << ") " << pattern_str << " queued " << (times[i].queued - first_queued) / 1000.0
+                  << " submit " << (times[i].submit - first_queued) / 1000.0 << " start "
+                  << (times[i].start - first_queued) / 1000.0 << " end " << (times[i].end - first_queued) / 1000.0
+                  << " us THROUGHPUT = " << cu_bytes / (times[i].end - times[i].start) << " GB/s" << std::endl;
+        results.add("Pattern Throughput", "GB/s", {{"pattern", pattern_str}},
+                    cu_bytes / (times[i].end - times[i].start));
+    }
+    std::cout << "Start skew = " << (last_start - first_start) / 1000.0
+              << " us, end skew = " << (last_end - first_end) / 1000.0
+              << " us, host launch overhead = " << launch_overhead * 1000000 << " us" << std::endl;
+    std::cout << std::defaultfloat;
+
+    // Aggregate over the window in which the compute units actually ran,
+    // the mean of the repeated launches
+    result = num_cu * cu_bytes;
+    result /= stats.mean * 1e9; // to GBps
 
     std::cout << "OVERALL THROUGHPUT = " << result << " GB/s" << std::endl;
-    std::cout << "CHANNEL THROUGHPUT = " << result / (NUM_KERNEL * 4) << " GB/s" << std::endl;
+    std::cout << "CHANNEL THROUGHPUT = " << result / (num_cu * 4) << " GB/s" << std::endl;
+    for (auto sample : stats.samples) {
+        double overall = num_cu * cu_bytes / (sample * 1e9);
+        results.add("Overall Throughput", "GB/s", {{"patterns", parser.value("patterns")}}, overall);
+        results.add("Channel Throughput", "GB/s", {{"patterns", parser.value("patterns")}}, overall / (num_cu * 4));
+    }
+    results.write();
 
     std::cout << "TEST PASSED" << std::endl;
     return EXIT_SUCCESS;
@@ -18,57 +18,32 @@
 Description:
  This a kernel design of performing both vector addition and vector
 multiplication
- on input vectors.
+ on input vectors. The same operation is built into one kernel per access
+pattern, the pattern policy decides which vector every iteration reads and
+writes.
 
 *******************************************************************************/
 #include "krnl_vaddmul.h"
-#include <ap_int.h>
 
-unsigned int minRand(unsigned int seed, int load) {
-    static ap_uint<32> lfsr;
-
-    if (load == 1) lfsr = seed;
-    bool b_32 = lfsr.get_bit(32 - 32);
-    bool b_22 = lfsr.get_bit(32 - 22);
-    bool b_2 = lfsr.get_bit(32 - 2);
-    bool b_1 = lfsr.get_bit(32 - 1);
-    bool new_bit = b_32 ^ b_22 ^ b_2 ^ b_1;
-    lfsr = lfsr >> 1;
-    lfsr.set_bit(31, new_bit);
-
-    return lfsr.to_uint();
-}
-
-extern "C" {
-void krnl_vaddmul(const v_dt* in1,             // Read-Only Vector 1
-                  const v_dt* in2,             // Read-Only Vector 2
-                  v_dt* out_add,               // Output Result for ADD
-                  v_dt* out_mul,               // Output Result for MUL
-                  const unsigned int size,     // Size in integer
-                  const unsigned int num_times // Running the same kernel operations num_times
-                  ) {
-#pragma HLS INTERFACE m_axi port = in1 offset = slave bundle = gmem0 latency = 300 num_read_outstanding = 64
-#pragma HLS INTERFACE m_axi port = in2 offset = slave bundle = gmem1 latency = 300 num_read_outstanding = 64
-#pragma HLS INTERFACE m_axi port = out_add offset = slave bundle = gmem2 // latency = 64
-#pragma HLS INTERFACE m_axi port = out_mul offset = slave bundle = gmem3 // latency = 64
-
-#pragma HLS INTERFACE s_axilite port = in1 bundle = control
-#pragma HLS INTERFACE s_axilite port = in2 bundle = control
-#pragma HLS INTERFACE s_axilite port = out_add bundle = control
-#pragma HLS INTERFACE s_axilite port = out_mul bundle = control
-
-#pragma HLS INTERFACE s_axilite port = size bundle = control
-#pragma HLS INTERFACE s_axilite port = num_times bundle = control
-#pragma HLS INTERFACE s_axilite port = return bundle = control
-
-    int in_index = 1;
-    unsigned int seed = 1;
+// Operation shared by all kernels, Pattern gives the index of every access
+template <typename Pattern>
+void vaddmul(const v_dt* in1,                         // Read-Only Vector 1
+             const v_dt* in2,                         // Read-Only Vector 2
+             v_dt* out_add,                           // Output Result for ADD
+             v_dt* out_mul,                           // Output Result for MUL
+             const typename Pattern::table_t* table,  // Pattern data, if any
+             const unsigned int size,                 // Size in integer
+             const unsigned int num_times,            // Running the same kernel operations num_times
+             const unsigned int param                 // Pattern parameter
+             ) {
+    unsigned int in_index = 0;
     unsigned int vSize = ((size - 1) / VDATA_SIZE) + 1;
 
     v_dt tmpIn1, tmpIn2;
     v_dt tmpOutAdd, tmpOutMul;
 
-    minRand(16807, 1);
+    Pattern pattern;
+    pattern.init(vSize, param);
 
 // Running same kernel operation num_times to keep the kernel busy for HBM
 // bandwidth testing
@@ -76,8 +51,7 @@ L_vops:
     for (int count = 0; count < num_times; count++) {
     vops1:
         for (int i = 0; i < vSize; i++) {
-            seed = minRand(31, 0);
-            in_index = (seed % vSize);
+            in_index = pattern.next(table);
             tmpIn1 = in1[in_index];
             tmpIn2 = in2[in_index];
 
@@ -92,4 +66,141 @@ L_vops:
         }
     }
 }
+
+extern "C" {
+void krnl_vaddmul_sequential(const v_dt* in1,             // Read-Only Vector 1
+                             const v_dt* in2,             // Read-Only Vector 2
+                             v_dt* out_add,               // Output Result for ADD
+                             v_dt* out_mul,               // Output Result for MUL
+                             const unsigned int size,     // Size in integer
+                             const unsigned int num_times, // Running the same kernel operations num_times
+                             const unsigned int param     // Pattern parameter
+                             ) {
+#pragma HLS INTERFACE m_axi port = in1 offset = slave bundle = gmem0 latency = 300 num_read_outstanding = 64
+#pragma HLS INTERFACE m_axi port = in2 offset = slave bundle = gmem1 latency = 300 num_read_outstanding = 64
+#pragma HLS INTERFACE m_axi port = out_add offset = slave bundle = gmem2 // latency = 64
+#pragma HLS INTERFACE m_axi port = out_mul offset = slave bundle = gmem3 // latency = 64
+
+#pragma HLS INTERFACE s_axilite port = in1 bundle = control
+#pragma HLS INTERFACE s_axilite port = in2 bundle = control
+#pragma HLS INTERFACE s_axilite port = out_add bundle = control
+#pragma HLS INTERFACE s_axilite port = out_mul bundle = control
+
+#pragma HLS INTERFACE s_axilite port = size bundle = control
+#pragma HLS INTERFACE s_axilite port = num_times bundle = control
+#pragma HLS INTERFACE s_axilite port = param bundle = control
+#pragma HLS INTERFACE s_axilite port = return bundle = control
+
+    vaddmul<SequentialPattern>(in1, in2, out_add, out_mul, nullptr, size, num_times, param);
+}
+
+void krnl_vaddmul_strided(const v_dt* in1,             // Read-Only Vector 1
+                          const v_dt* in2,             // Read-Only Vector 2
+                          v_dt* out_add,               // Output Result for ADD
+                          v_dt* out_mul,               // Output Result for MUL
+                          const unsigned int size,     // Size in integer
+                          const unsigned int num_times, // Running the same kernel operations num_times
+                          const unsigned int param     // Pattern parameter
+                          ) {
+#pragma HLS INTERFACE m_axi port = in1 offset = slave bundle = gmem0 latency = 300 num_read_outstanding = 64
+#pragma HLS INTERFACE m_axi port = in2 offset = slave bundle = gmem1 latency = 300 num_read_outstanding = 64
+#pragma HLS INTERFACE m_axi port = out_add offset = slave bundle = gmem2 // latency = 64
+#pragma HLS INTERFACE m_axi port = out_mul offset = slave bundle = gmem3 // latency = 64
+
+#pragma HLS INTERFACE s_axilite port = in1 bundle = control
+#pragma HLS INTERFACE s_axilite port = in2 bundle = control
+#pragma HLS INTERFACE s_axilite port = out_add bundle = control
+#pragma HLS INTERFACE s_axilite port = out_mul bundle = control
+
+#pragma HLS INTERFACE s_axilite port = size bundle = control
+#pragma HLS INTERFACE s_axilite port = num_times bundle = control
+#pragma HLS INTERFACE s_axilite port = param bundle = control
+#pragma HLS INTERFACE s_axilite port = return bundle = control
+
+    vaddmul<StridedPattern>(in1, in2, out_add, out_mul, nullptr, size, num_times, param);
+}
+
+void krnl_vaddmul_lfsr(const v_dt* in1,             // Read-Only Vector 1
+                       const v_dt* in2,             // Read-Only Vector 2
+                       v_dt* out_add,               // Output Result for ADD
+                       v_dt* out_mul,               // Output Result for MUL
+                       const unsigned int size,     // Size in integer
+                       const unsigned int num_times, // Running the same kernel operations num_times
+                       const unsigned int param     // Pattern parameter
+                       ) {
+#pragma HLS INTERFACE m_axi port = in1 offset = slave bundle = gmem0 latency = 300 num_read_outstanding = 64
+#pragma HLS INTERFACE m_axi port = in2 offset = slave bundle = gmem1 latency = 300 num_read_outstanding = 64
+#pragma HLS INTERFACE m_axi port = out_add offset = slave bundle = gmem2 // latency = 64
+#pragma HLS INTERFACE m_axi port = out_mul offset = slave bundle = gmem3 // latency = 64
+
+#pragma HLS INTERFACE s_axilite port = in1 bundle = control
+#pragma HLS INTERFACE s_axilite port = in2 bundle = control
+#pragma HLS INTERFACE s_axilite port = out_add bundle = control
+#pragma HLS INTERFACE s_axilite port = out_mul bundle = control
+
+#pragma HLS INTERFACE s_axilite port = size bundle = control
+#pragma HLS INTERFACE s_axilite port = num_times bundle = control
+#pragma HLS INTERFACE s_axilite port = param bundle = control
+#pragma HLS INTERFACE s_axilite port = return bundle = control
+
+    vaddmul<LfsrPattern>(in1, in2, out_add, out_mul, nullptr, size, num_times, param);
+}
+
+void krnl_vaddmul_table(const v_dt* in1,             // Read-Only Vector 1
+                        const v_dt* in2,             // Read-Only Vector 2
+                        v_dt* out_add,               // Output Result for ADD
+                        v_dt* out_mul,               // Output Result for MUL
+                        const uint32_t* table,        // Pattern data
+                        const unsigned int size,     // Size in integer
+                        const unsigned int num_times, // Running the same kernel operations num_times
+                        const unsigned int param     // Pattern parameter
+                        ) {
+#pragma HLS INTERFACE m_axi port = in1 offset = slave bundle = gmem0 latency = 300 num_read_outstanding = 64
+#pragma HLS INTERFACE m_axi port = in2 offset = slave bundle = gmem1 latency = 300 num_read_outstanding = 64
+#pragma HLS INTERFACE m_axi port = out_add offset = slave bundle = gmem2 // latency = 64
+#pragma HLS INTERFACE m_axi port = out_mul offset = slave bundle = gmem3 // latency = 64
+#pragma HLS INTERFACE m_axi port = table offset = slave bundle = gmem4 latency = 300 num_read_outstanding = 64
+
+#pragma HLS INTERFACE s_axilite port = in1 bundle = control
+#pragma HLS INTERFACE s_axilite port = in2 bundle = control
+#pragma HLS INTERFACE s_axilite port = out_add bundle = control
+#pragma HLS INTERFACE s_axilite port = out_mul bundle = control
+#pragma HLS INTERFACE s_axilite port = table bundle = control
+
+#pragma HLS INTERFACE s_axilite port = size bundle = control
+#pragma HLS INTERFACE s_axilite port = num_times bundle = control
+#pragma HLS INTERFACE s_axilite port = param bundle = control
+#pragma HLS INTERFACE s_axilite port = return bundle = control
+
+    vaddmul<TablePattern>(in1, in2, out_add, out_mul, table, size, num_times, param);
+}
+
+void krnl_vaddmul_zipf(const v_dt* in1,             // Read-Only Vector 1
+                       const v_dt* in2,             // Read-Only Vector 2
+                       v_dt* out_add,               // Output Result for ADD
+                       v_dt* out_mul,               // Output Result for MUL
+                       const ap_uint<64>* table,     // Pattern data
+                       const unsigned int size,     // Size in integer
+                       const unsigned int num_times, // Running the same kernel operations num_times
+                       const unsigned int param     // Pattern parameter
+                       ) {
+#pragma HLS INTERFACE m_axi port = in1 offset = slave bundle = gmem0 latency = 300 num_read_outstanding = 64
+#pragma HLS INTERFACE m_axi port = in2 offset = slave bundle = gmem1 latency = 300 num_read_outstanding = 64
+#pragma HLS INTERFACE m_axi port = out_add offset = slave bundle = gmem2 // latency = 64
+#pragma HLS INTERFACE m_axi port = out_mul offset = slave bundle = gmem3 // latency = 64
+#pragma HLS INTERFACE m_axi port = table offset = slave bundle = gmem4 latency = 300 num_read_outstanding = 64
+
+#pragma HLS INTERFACE s_axilite port = in1 bundle = control
+#pragma HLS INTERFACE s_axilite port = in2 bundle = control
+#pragma HLS INTERFACE s_axilite port = out_add bundle = control
+#pragma HLS INTERFACE s_axilite port = out_mul bundle = control
+#pragma HLS INTERFACE s_axilite port = table bundle = control
+
+#pragma HLS INTERFACE s_axilite port = size bundle = control
+#pragma HLS INTERFACE s_axilite port = num_times bundle = control
+#pragma HLS INTERFACE s_axilite port = param bundle = control
+#pragma HLS INTERFACE s_axilite port = return bundle = control
+
+    vaddmul<ZipfPattern>(in1, in2, out_add, out_mul, table, size, num_times, param);
+}
 }
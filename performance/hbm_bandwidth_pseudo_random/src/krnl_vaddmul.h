@@ -13,6 +13,7 @@
 * License for the specific language governing permissions and limitations
 * under the License.
 */
+#include <ap_int.h>
 #include <stdint.h>
 
 #define VDATA_SIZE 32
@@ -23,3 +24,116 @@ const unsigned int c_dt_size = VDATA_SIZE;
 struct v_dt {
     uint32_t data[VDATA_SIZE];
 } __attribute__((aligned(128)));
+
+// Access pattern policies of the kernels. Each one is instantiated in its own
+// kernel and generates the vector index of every access in [0, vSize). The
+// policies that need data from global memory read it through table, which
+// is only connected to a port by the kernels using it.
+
+// 32 bit LFSR with taps 32, 22, 2 and 1
+inline ap_uint<32> lfsr_next(ap_uint<32> lfsr) {
+    bool b_32 = lfsr.get_bit(32 - 32);
+    bool b_22 = lfsr.get_bit(32 - 22);
+    bool b_2 = lfsr.get_bit(32 - 2);
+    bool b_1 = lfsr.get_bit(32 - 1);
+    bool new_bit = b_32 ^ b_22 ^ b_2 ^ b_1;
+    lfsr = lfsr >> 1;
+    lfsr.set_bit(31, new_bit);
+    return lfsr;
+}
+
+// 0, 1, 2, ... vSize - 1, 0, 1, ...
+struct SequentialPattern {
+    typedef uint32_t table_t;
+    unsigned int vSize;
+    unsigned int index;
+
+    void init(unsigned int size, unsigned int param) {
+        vSize = size;
+        index = 0;
+    }
+    unsigned int next(const table_t* table) {
+        unsigned int result = index;
+        index = (index + 1 == vSize) ? 0 : index + 1;
+        return result;
+    }
+};
+
+// Every param-th vector, wrapping around. An odd stride visits every vector
+// of a power of two sized buffer once per pass.
+struct StridedPattern {
+    typedef uint32_t table_t;
+    unsigned int vSize;
+    unsigned int step;
+    unsigned int index;
+
+    void init(unsigned int size, unsigned int param) {
+        vSize = size;
+        step = param % size;
+        index = 0;
+    }
+    unsigned int next(const table_t* table) {
+        unsigned int result = index;
+        index += step;
+        if (index >= vSize) index -= vSize;
+        return result;
+    }
+};
+
+// Uniform pseudo random indices from the LFSR, the original access pattern
+// of this example
+struct LfsrPattern {
+    typedef uint32_t table_t;
+    unsigned int vSize;
+    ap_uint<32> lfsr;
+
+    void init(unsigned int size, unsigned int param) {
+        vSize = size;
+        lfsr = lfsr_next(16807);
+    }
+    unsigned int next(const table_t* table) {
+        lfsr = lfsr_next(lfsr);
+        return lfsr.to_uint() % vSize;
+    }
+};
+
+// Gather by index: table holds vSize indices, built by the host, which are
+// used in order
+struct TablePattern {
+    typedef uint32_t table_t;
+    unsigned int vSize;
+    unsigned int pos;
+
+    void init(unsigned int size, unsigned int param) {
+        vSize = size;
+        pos = 0;
+    }
+    unsigned int next(const table_t* table) {
+        unsigned int result = table[pos];
+        pos = (pos + 1 == vSize) ? 0 : pos + 1;
+        return result;
+    }
+};
+
+// Skewed indices drawn with the alias method. table holds one entry per
+// vector, the probability of keeping the drawn vector scaled to 2^32 in the
+// low word and the vector used otherwise in the high word.
+struct ZipfPattern {
+    typedef ap_uint<64> table_t;
+    unsigned int vSize;
+    ap_uint<32> slot_lfsr;
+    ap_uint<32> coin_lfsr;
+
+    void init(unsigned int size, unsigned int param) {
+        vSize = size;
+        slot_lfsr = lfsr_next(16807);
+        coin_lfsr = lfsr_next(48271);
+    }
+    unsigned int next(const table_t* table) {
+        slot_lfsr = lfsr_next(slot_lfsr);
+        coin_lfsr = lfsr_next(coin_lfsr);
+        unsigned int slot = slot_lfsr.to_uint() % vSize;
+        table_t entry = table[slot];
+        return (coin_lfsr < entry.range(31, 0)) ? slot : (unsigned int)entry.range(63, 32);
+    }
+};
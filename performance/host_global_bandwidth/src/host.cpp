@@ -15,47 +15,43 @@
 */
 
 #include <CL/opencl.h>
+#include <algorithm>
 #include <chrono>
 #include <ctime>
 #include <fstream>
+#include <future>
 #include <iostream>
+#include <limits>
+#include <thread>
 #include <vector>
 
+#include "benchmark.hpp"
+#include "bufpool.hpp"
+#include "cmdlineparser.h"
+#include "results.hpp"
 #include "xcl2.hpp"
 
 double throput_max_host_to_dev[3] = {0};
 double throput_max_dev_to_host[3] = {0};
 double throput_max_bidirectional[3] = {0};
+xcl::Results results("host_global_bandwidth");
+xcl::Benchmark bench;
 
-////////////////////////////////////////////////////////////////////////////////
-class Timer {
-    std::chrono::high_resolution_clock::time_point mTimeStart;
-
-   public:
-    Timer() { reset(); }
-    long long stop() {
-        std::chrono::high_resolution_clock::time_point timeEnd = std::chrono::high_resolution_clock::now();
-        return std::chrono::duration_cast<std::chrono::microseconds>(timeEnd - mTimeStart).count();
-    }
-    void reset() { mTimeStart = std::chrono::high_resolution_clock::now(); }
-};
-
-static int host_to_dev(cl::CommandQueue commands, int buff_size, std::vector<cl::Memory>& mems, std::ostream& strm) {
+static int host_to_dev(cl::CommandQueue commands, size_t buff_size, std::vector<cl::Memory>& mems, std::ostream& strm) {
     cl_int err;
-    Timer timer;
-    OCL_CHECK(err, err = commands.enqueueMigrateMemObjects(mems, 0 /* 0 means from host*/));
+    auto stats = bench.run([&] {
+        OCL_CHECK(err, err = commands.enqueueMigrateMemObjects(mems, 0 /* 0 means from host*/));
+        commands.finish();
+    });
 
-    commands.finish();
-
-    double timer_stop2 = timer.stop();
-    double throput = (double)(buff_size * mems.size());
-    throput *= 1000000;     // convert us to s;
-    throput /= 1024 * 1024; // convert to MB
-    throput /= timer_stop2;
+    double mbytes = (double)(buff_size * mems.size()) / (1024 * 1024); // convert to MB
+    double throput = mbytes / stats.mean;
     double dbuff_size = (double)(buff_size) / 1024; // convert to KB
     std::cout << "OpenCL migration BW host to device: " << throput << " MB/s"
               << " for buffer size " << dbuff_size << " KB with " << mems.size() << " buffers\n";
     strm << "Host to Card, " << dbuff_size << " KB, " << mems.size() << ", " << throput << "\n";
+    for (auto sample : stats.samples)
+        results.add("Host to Card", "MB/s", {{"buffer_size", buff_size}, {"buffers", mems.size()}}, mbytes / sample);
 
     if (throput > throput_max_host_to_dev[0]) {
         throput_max_host_to_dev[0] = throput;
@@ -65,22 +61,21 @@ static int host_to_dev(cl::CommandQueue commands, int buff_size, std::vector<cl:
     return CL_SUCCESS;
 }
 
-static int dev_to_host(cl::CommandQueue commands, int buff_size, std::vector<cl::Memory>& mems, std::ostream& strm) {
+static int dev_to_host(cl::CommandQueue commands, size_t buff_size, std::vector<cl::Memory>& mems, std::ostream& strm) {
     cl_int err;
-    Timer timer;
-    OCL_CHECK(err, err = commands.enqueueMigrateMemObjects(mems, CL_MIGRATE_MEM_OBJECT_HOST));
+    auto stats = bench.run([&] {
+        OCL_CHECK(err, err = commands.enqueueMigrateMemObjects(mems, CL_MIGRATE_MEM_OBJECT_HOST));
+        commands.finish();
+    });
 
-    commands.finish();
-
-    long long timer_stop2 = timer.stop();
-    double throput = (double)(buff_size * mems.size());
-    throput *= 1000000;     // convert us to s;
-    throput /= 1024 * 1024; // convert to MB
-    throput /= timer_stop2;
+    double mbytes = (double)(buff_size * mems.size()) / (1024 * 1024); // convert to MB
+    double throput = mbytes / stats.mean;
     double dbuff_size = (double)(buff_size) / 1024; // convert to KB
     std::cout << "OpenCL migration BW device to host: " << throput << " MB/s"
               << " for buffer size " << dbuff_size << " KB with " << mems.size() << " buffers\n";
     strm << "Card to Host, " << dbuff_size << " KB, " << mems.size() << ", " << throput << "\n";
+    for (auto sample : stats.samples)
+        results.add("Card to Host", "MB/s", {{"buffer_size", buff_size}, {"buffers", mems.size()}}, mbytes / sample);
     if (throput > throput_max_dev_to_host[0]) {
         throput_max_dev_to_host[0] = throput;
         throput_max_dev_to_host[1] = dbuff_size;
@@ -90,7 +85,7 @@ static int dev_to_host(cl::CommandQueue commands, int buff_size, std::vector<cl:
 }
 
 static int bidirectional(cl::CommandQueue commands,
-                         int buff_size,
+                         size_t buff_size,
                          std::vector<cl::Memory>& mems1,
                          std::vector<cl::Memory>& mems2,
                          std::ostream& strm) {
@@ -99,22 +94,22 @@ static int bidirectional(cl::CommandQueue commands,
     OCL_CHECK(err, err = commands.enqueueMigrateMemObjects(mems2, 0 /* 0 means from host*/));
     commands.finish();
 
-    Timer timer;
-    OCL_CHECK(err, err = commands.enqueueMigrateMemObjects(mems1, 0 /* 0 means from host*/));
-    OCL_CHECK(err, err = commands.enqueueMigrateMemObjects(mems2, CL_MIGRATE_MEM_OBJECT_HOST));
-
-    commands.finish();
+    auto stats = bench.run([&] {
+        OCL_CHECK(err, err = commands.enqueueMigrateMemObjects(mems1, 0 /* 0 means from host*/));
+        OCL_CHECK(err, err = commands.enqueueMigrateMemObjects(mems2, CL_MIGRATE_MEM_OBJECT_HOST));
+        commands.finish();
+    });
 
-    long long timer_stop2 = timer.stop();
-    double throput = (double)(buff_size * (mems1.size() + mems2.size()));
-    throput *= 1000000;     // convert us to s;
-    throput /= 1024 * 1024; // convert to MB
-    throput /= timer_stop2;
+    double mbytes = (double)(buff_size * (mems1.size() + mems2.size())) / (1024 * 1024); // convert to MB
+    double throput = mbytes / stats.mean;
     double dbuff_size = (double)(buff_size) / 1024; // convert to KB
     std::cout << "OpenCL migration BW "
               << "overall: " << throput << " MB/s for buffer size " << dbuff_size << " KB with " << mems1.size()
               << " buffers\n";
-    strm << "Card to Host, " << dbuff_size << " KB, " << mems1.size() << ", " << throput << "\n";
+    strm << "Bidirectional, " << dbuff_size << " KB, " << mems1.size() << ", " << throput << "\n";
+    for (auto sample : stats.samples)
+        results.add("Bidirectional", "MB/s", {{"buffer_size", buff_size}, {"buffers", mems1.size()}},
+                    mbytes / sample);
 
     if (throput > throput_max_bidirectional[0]) {
         throput_max_bidirectional[0] = throput;
@@ -124,33 +119,221 @@ static int bidirectional(cl::CommandQueue commands,
     return CL_SUCCESS;
 }
 
+// Window from the earliest start to the latest end of a set of
+// migrations, from their profiling events, in ns
+struct window_t {
+    cl_ulong start = std::numeric_limits<cl_ulong>::max();
+    cl_ulong end = 0;
+
+    void add(const cl::Event& event) {
+        xcl::EventTimes times = xcl::get_event_times(event);
+        start = std::min(start, times.start);
+        end = std::max(end, times.end);
+    }
+    void add(const window_t& other) {
+        start = std::min(start, other.start);
+        end = std::max(end, other.end);
+    }
+    // MB/s of the given bytes over the window
+    double bandwidth(double bytes) const { return bytes * 1000 / (1024 * 1024) / (end - start); }
+};
+
+// Buffers, queue and results of one host thread of the concurrent mode
+struct stream_t {
+    cl::CommandQueue queue;
+    std::vector<xcl::ClBufferPool::Lease> h2d;
+    std::vector<xcl::ClBufferPool::Lease> d2h;
+    double h2d_bytes;
+    double d2h_bytes;
+    window_t h2d_window;
+    window_t d2h_window;
+};
+
+// Keeps up to depth host to device and depth device to host migrations of
+// the thread's own buffers in flight on its queue, until transfers
+// migrations of each direction are done. Waits for the common start first.
+// Every migration is timed on the device by its profiling event, so each
+// direction gets its own window.
+static void concurrent_stream(stream_t& st, int transfers, size_t buff_size, std::shared_future<void> start) {
+    cl_int err;
+    int depth = st.h2d.size();
+    std::vector<cl::Event> h2d_events(depth);
+    std::vector<cl::Event> d2h_events(depth);
+    start.wait();
+
+    for (int n = 0; n < transfers; n++) {
+        int slot = n % depth;
+        // reuse a slot once its previous migrations are done
+        if (n >= depth) {
+            OCL_CHECK(err, err = h2d_events[slot].wait());
+            OCL_CHECK(err, err = d2h_events[slot].wait());
+            st.h2d_window.add(h2d_events[slot]);
+            st.d2h_window.add(d2h_events[slot]);
+        }
+        OCL_CHECK(err, err = st.queue.enqueueMigrateMemObjects({st.h2d[slot].get()}, 0 /* 0 means from host*/,
+                                                               nullptr, &h2d_events[slot]));
+        OCL_CHECK(err, err = st.queue.enqueueMigrateMemObjects({st.d2h[slot].get()}, CL_MIGRATE_MEM_OBJECT_HOST,
+                                                               nullptr, &d2h_events[slot]));
+    }
+    OCL_CHECK(err, err = st.queue.finish());
+    for (int slot = 0; slot < std::min(depth, transfers); slot++) {
+        st.h2d_window.add(h2d_events[slot]);
+        st.d2h_window.add(d2h_events[slot]);
+    }
+
+    st.h2d_bytes = (double)buff_size * transfers;
+    st.d2h_bytes = (double)buff_size * transfers;
+}
+
+// Runs num_threads host threads, each with its own queue and buffers,
+// migrating in both directions at once, and reports the bandwidth of every
+// thread, the aggregate bandwidth and how evenly it is shared. The bandwidth
+// of a direction is taken over the window of its own migrations, the total
+// over the window of both.
+static int concurrent(const cl::Context& context,
+                      const cl::Device& device,
+                      cl::Kernel& krnl,
+                      xcl::ClBufferPool& pool,
+                      int num_threads,
+                      int depth,
+                      int transfers,
+                      size_t buff_size,
+                      std::ostream& strm) {
+    cl_int err;
+    double dbuff_size = (double)(buff_size) / 1024; // convert to KB
+    std::cout << "\nConcurrent migration with " << num_threads << " threads, depth " << depth << ", buffer size "
+              << dbuff_size << " KB, " << transfers << " transfers per direction and thread\n";
+
+    // Buffers are set up from this thread before the streams start, so
+    // only the migrations are timed
+    std::vector<stream_t> streams(num_threads);
+    for (auto& st : streams) {
+        OCL_CHECK(err, st.queue = cl::CommandQueue(
+                           context, device, CL_QUEUE_PROFILING_ENABLE | CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, &err));
+        for (int i = 0; i < depth; i++) {
+            st.h2d.push_back(pool.lease(buff_size, -1, CL_MEM_READ_WRITE));
+            st.d2h.push_back(pool.lease(buff_size, -1, CL_MEM_READ_WRITE));
+            OCL_CHECK(err, err = krnl.setArg(0, st.h2d[i].get()));
+            OCL_CHECK(err, err = krnl.setArg(1, st.d2h[i].get()));
+            // Writing to avoid read-without-write case in DDR
+            OCL_CHECK(err, err = st.queue.enqueueFillBuffer<int>(st.h2d[i].get(), i, 0, buff_size, 0, 0));
+            OCL_CHECK(err, err = st.queue.enqueueFillBuffer<int>(st.d2h[i].get(), i, 0, buff_size, 0, 0));
+        }
+        OCL_CHECK(err, err = st.queue.finish());
+    }
+
+    std::promise<void> go;
+    std::shared_future<void> start = go.get_future().share();
+    std::vector<std::thread> threads;
+    for (auto& st : streams) {
+        threads.emplace_back(concurrent_stream, std::ref(st), transfers, buff_size, start);
+    }
+    go.set_value();
+    for (auto& t : threads) t.join();
+
+    double total_h2d = 0, total_d2h = 0;
+    double sum = 0, sum_sq = 0, slowest = 0, fastest = 0;
+    window_t all_h2d, all_d2h;
+    for (int i = 0; i < num_threads; i++) {
+        stream_t& st = streams[i];
+        window_t both = st.h2d_window;
+        both.add(st.d2h_window);
+        double h2d = st.h2d_window.bandwidth(st.h2d_bytes);
+        double d2h = st.d2h_window.bandwidth(st.d2h_bytes);
+        double total = both.bandwidth(st.h2d_bytes + st.d2h_bytes);
+        std::cout << "  Thread " << i << ": host to device " << h2d << " MB/s, device to host " << d2h
+                  << " MB/s, total " << total << " MB/s\n";
+        total_h2d += st.h2d_bytes;
+        total_d2h += st.d2h_bytes;
+        sum += total;
+        sum_sq += total * total;
+        slowest = (i == 0) ? total : std::min(slowest, total);
+        fastest = std::max(fastest, total);
+        all_h2d.add(st.h2d_window);
+        all_d2h.add(st.d2h_window);
+    }
+
+    // The aggregate of a direction is taken over the window from its
+    // earliest start to its latest end in any thread
+    window_t all = all_h2d;
+    all.add(all_d2h);
+    double h2d = all_h2d.bandwidth(total_h2d);
+    double d2h = all_d2h.bandwidth(total_d2h);
+    double total = all.bandwidth(total_h2d + total_d2h);
+    // Jain's fairness index, 1 when all threads get the same bandwidth
+    double fairness = (sum * sum) / (num_threads * sum_sq);
+    std::cout << "  Aggregate: host to device " << h2d << " MB/s, device to host " << d2h << " MB/s, total "
+              << total << " MB/s\n";
+    std::cout << "  Fairness (Jain's index) = " << fairness << ", slowest thread at " << 100 * slowest / fastest
+              << " % of the fastest\n";
+    strm << "Concurrent Host to Card, " << dbuff_size << " KB, " << num_threads << ", " << h2d << "\n";
+    strm << "Concurrent Card to Host, " << dbuff_size << " KB, " << num_threads << ", " << d2h << "\n";
+    xcl::Results::Params params = {{"buffer_size", buff_size}, {"threads", num_threads}, {"depth", depth}};
+    results.add("Concurrent Host to Card", "MB/s", params, h2d);
+    results.add("Concurrent Card to Host", "MB/s", params, d2h);
+    results.add("Concurrent Fairness", "", params, fairness);
+    return CL_SUCCESS;
+}
+
 int main(int argc, char** argv) {
-    if (argc != 2) {
-        std::cout << "Usage: " << argv[0] << " <XCLBIN File>" << std::endl;
+    if (argc < 2) {
+        std::cout << "Usage: " << argv[0]
+                  << " <XCLBIN File> [-s <buffer sizes> -c <buffer counts>] [-t <threads> -d <depth> -n <transfers>]"
+                  << std::endl;
         return EXIT_FAILURE;
     }
 
     std::string binaryFile = argv[1];
 
+    // Optional switches follow the xclbin file
+    sda::utils::CmdLineParser parser;
+    parser.addSwitch("--sizes", "-s", "buffer sizes, a list or range such as 64..512M:x4", "");
+    parser.addSwitch("--counts", "-c", "buffer counts per size, a list or range", "8");
+    parser.addSwitch("--threads", "-t", "host threads of the concurrent mode, a list or range such as 1..8", "");
+    parser.addSwitch("--depth", "-d", "migrations in flight per direction and thread, a list or range", "2");
+    parser.addSwitch("--transfers", "-n", "migrations per direction and thread", "64");
+    if (parser.parse(argc - 1, argv + 1) < 0) {
+        return EXIT_FAILURE;
+    }
+
     // Variable-------------------------------------------------------------------------------
 
-    int buff_tab[][2] = {{64, 1024},    {256, 1024},    {512, 1024},    {1024, 1024},   {4096, 1024},
+    size_t buff_tab[][2] = {{64, 1024},    {256, 1024},    {512, 1024},    {1024, 1024},   {4096, 1024},
                          {16384, 512},  {1048576, 8},   {1048576, 64},  {1048576, 256}, {2097152, 8},
                          {2097152, 64}, {2097152, 256}, {16777216, 64}, {268435456, 4}, {536870912, 2}};
 
+    // (buffer size, buffer count) rows, either the table above or the
+    // product of the sizes and counts given on the command line
+    std::vector<std::pair<size_t, size_t> > rows;
+    if (parser.value("sizes").empty()) {
+        for (size_t i = 0; i < sizeof(buff_tab) / sizeof(buff_tab[0]); i++) {
+            rows.push_back(std::make_pair(buff_tab[i][0], buff_tab[i][1]));
+        }
+    } else {
+        auto sweep = parser.sweep({"sizes", "counts"});
+        if (sweep.size() == 0) {
+            parser.printHelp();
+            return EXIT_FAILURE;
+        }
+        for (auto point : sweep) {
+            rows.push_back(std::make_pair(point["sizes"], point["counts"]));
+        }
+    }
+
     cl_int err;
     cl::Context context;
     cl::CommandQueue command_queue;
     cl::Kernel krnl_bandwidth;
+    cl::Device device;
     // The get_xil_devices will return vector of Xilinx Devices
     auto devices = xcl::get_xil_devices();
 
     // read_binary() command will find the OpenCL binary file
-    auto fileBuf = xcl::read_binary_file(binaryFile);
-    cl::Program::Binaries bins{{fileBuf.data(), fileBuf.size()}};
+    auto fileBuf = xcl::map_binary_file(binaryFile);
+    cl::Program::Binaries bins{{fileBuf->data(), fileBuf->size()}};
     bool valid_device = false;
     for (unsigned int i = 0; i < devices.size(); i++) {
-        auto device = devices[i];
+        device = devices[i];
         // Creating Context and Command Queue for selected Device
         OCL_CHECK(err, context = cl::Context(device, nullptr, nullptr, nullptr, &err));
         OCL_CHECK(err, command_queue = cl::CommandQueue(
@@ -172,23 +355,61 @@ int main(int argc, char** argv) {
         exit(EXIT_FAILURE);
     }
 
-    int dim1 = sizeof(buff_tab) / (2 * 4);
+    int dim1 = rows.size();
     if (xcl::is_emulation()) {
-        dim1 = 2; // Reducing combinations to run faster in emulation flow
+        dim1 = std::min(dim1, 2); // Reducing combinations to run faster in emulation flow
     }
 
+    // Buffers are leased from a pool so that rows sharing a buffer size, and
+    // the bidirectional pass, reuse device allocations made earlier. Idle
+    // buffers are capped at 1 GB to stay within a single DDR bank.
+    xcl::ClBufferPool pool(xcl::ClBufferAllocator(context, command_queue), 1024 * 1024 * 1024);
+
     std::ofstream handle("metric1.csv");
     handle << "Direction, Buffer Size (bytes), Count, Bandwidth (MB/s)\n";
 
+    // Concurrent mode, replacing the single queue passes below
+    if (!parser.value("threads").empty()) {
+        auto sweep = parser.sweep({"threads", "depth"});
+        std::vector<uint64_t> sizes = {2 * 1024 * 1024};
+        if (!parser.value("sizes").empty()) sizes = parser.value_to_list("sizes");
+        int transfers = parser.value_to_int("transfers");
+        if (sweep.size() == 0 || sizes.empty() || transfers < 1) {
+            parser.printHelp();
+            return EXIT_FAILURE;
+        }
+        if (xcl::is_emulation()) {
+            sizes = {4096}; // Reducing the data size to run faster in emulation flow
+            transfers = 4;
+        }
+        for (auto point : sweep) {
+            for (auto size : sizes) {
+                if (point["threads"] < 1 || point["depth"] < 1) continue;
+                err = concurrent(context, device, krnl_bandwidth, pool, point["threads"], point["depth"], transfers,
+                                 size, handle);
+                if (err != CL_SUCCESS) break;
+            }
+        }
+        std::cout << "\nDevice buffers created: " << pool.created() << "\n";
+        results.write();
+        printf("\nTEST PASSED\n");
+        handle.close();
+        return EXIT_SUCCESS;
+    }
+
+    // Every migration below is repeated by the benchmark harness
+    bench.describe();
     for (int buff_size_1 = 0; buff_size_1 < dim1; buff_size_1++) {
-        int nxtcnt = buff_tab[buff_size_1][0];
-        int buff_cnt = buff_tab[buff_size_1][1];
+        size_t nxtcnt = rows[buff_size_1].first;
+        size_t buff_cnt = rows[buff_size_1].second;
         std::vector<cl::Memory> mems(buff_cnt);
+        std::vector<xcl::ClBufferPool::Lease> leases(buff_cnt);
 
-        for (int i = buff_cnt - 1; i >= 0; i--) {
-            OCL_CHECK(err, mems[i] = cl::Buffer(context, (cl_mem_flags)(CL_MEM_READ_WRITE), nxtcnt, nullptr, &err));
+        for (size_t i = buff_cnt; i-- > 0;) {
+            leases[i] = pool.lease(nxtcnt, -1, CL_MEM_READ_WRITE);
+            mems[i] = leases[i].get();
             OCL_CHECK(err, err = krnl_bandwidth.setArg(0, mems[i]));
-            OCL_CHECK(err, err = command_queue.enqueueFillBuffer<int>((cl::Buffer&)mems[i], i, 0, nxtcnt, 0, 0));
+            OCL_CHECK(err, err = command_queue.enqueueFillBuffer<int>((cl::Buffer&)mems[i], (int)i, 0, nxtcnt, 0, 0));
         }
 
         if (err != CL_SUCCESS) {
@@ -210,18 +431,22 @@ int main(int argc, char** argv) {
 
     printf("\nThe bandwidth numbers for bidirectional case:\n");
     for (int buff_size_1 = 0; buff_size_1 < dim1; buff_size_1++) {
-        int nxtcnt = buff_tab[buff_size_1][0];
-        int buff_cnt = buff_tab[buff_size_1][1];
+        size_t nxtcnt = rows[buff_size_1].first;
+        size_t buff_cnt = rows[buff_size_1].second;
         std::vector<cl::Memory> mems1(buff_cnt);
         std::vector<cl::Memory> mems2(buff_cnt);
+        std::vector<xcl::ClBufferPool::Lease> leases1(buff_cnt);
+        std::vector<xcl::ClBufferPool::Lease> leases2(buff_cnt);
 
-        for (int i = buff_cnt - 1; i >= 0; i--) {
-            OCL_CHECK(err, mems1[i] = cl::Buffer(context, (cl_mem_flags)(CL_MEM_READ_WRITE), nxtcnt, nullptr, &err));
+        for (size_t i = buff_cnt; i-- > 0;) {
+            leases1[i] = pool.lease(nxtcnt, -1, CL_MEM_READ_WRITE);
+            mems1[i] = leases1[i].get();
             OCL_CHECK(err, err = krnl_bandwidth.setArg(0, mems1[i]));
-            OCL_CHECK(err, err = command_queue.enqueueFillBuffer<int>((cl::Buffer&)mems1[i], i, 0, nxtcnt, 0, 0));
-            OCL_CHECK(err, mems2[i] = cl::Buffer(context, (cl_mem_flags)(CL_MEM_READ_WRITE), nxtcnt, nullptr, &err));
+            OCL_CHECK(err, err = command_queue.enqueueFillBuffer<int>((cl::Buffer&)mems1[i], (int)i, 0, nxtcnt, 0, 0));
+            leases2[i] = pool.lease(nxtcnt, -1, CL_MEM_READ_WRITE);
+            mems2[i] = leases2[i].get();
             OCL_CHECK(err, err = krnl_bandwidth.setArg(1, mems2[i]));
-            OCL_CHECK(err, err = command_queue.enqueueFillBuffer<int>((cl::Buffer&)mems2[i], i, 0, nxtcnt, 0, 0));
+            OCL_CHECK(err, err = command_queue.enqueueFillBuffer<int>((cl::Buffer&)mems2[i], (int)i, 0, nxtcnt, 0, 0));
         }
 
         if (err != CL_SUCCESS) {
@@ -251,9 +476,12 @@ int main(int argc, char** argv) {
     std::cout << "OpenCL migration BW "
               << "overall: " << throput_max_bidirectional[0] << " MB/s for buffer size " << throput_max_bidirectional[1]
               << " KB with " << throput_max_bidirectional[2] << " buffers\n";
-    handle << "Card to Host, " << throput_max_bidirectional[1] << " KB, " << throput_max_bidirectional[2] << ", "
+    handle << "Bidirectional, " << throput_max_bidirectional[1] << " KB, " << throput_max_bidirectional[2] << ", "
            << throput_max_bidirectional[0] << "\n";
 
+    std::cout << "\nDevice buffers created: " << pool.created() << "\n";
+    results.write();
+
     printf("\nTEST PASSED\n");
     // Shutdown and cleanup
     handle.close();
@@ -14,6 +14,8 @@
 * under the License.
 */
 
+#include "benchmark.hpp"
+#include "results.hpp"
 #include "xcl2.hpp"
 #include <CL/cl_ext_xilinx.h>
 
@@ -32,9 +34,9 @@ int main(int argc, char* argv[]) {
     // The get_xil_devices will return vector of Xilinx Devices
     auto devices = xcl::get_xil_devices();
 
-    auto fileBuf = xcl::read_binary_file(binaryFile);
+    auto fileBuf = xcl::map_binary_file(binaryFile);
 
-    cl::Program::Binaries bins{{fileBuf.data(), fileBuf.size()}};
+    cl::Program::Binaries bins{{fileBuf->data(), fileBuf->size()}};
     bool valid_device = false;
     for (unsigned int i = 0; i < devices.size(); i++) {
         auto device = devices[i];
@@ -64,6 +66,10 @@ int main(int argc, char* argv[]) {
     double concurrent_max = 0;
     double read_max = 0;
     double write_max = 0;
+    xcl::Results results("host_memory_bandwidth");
+    // Every throughput is the mean of repeated runs after a warmup run
+    xcl::Benchmark bench;
+    bench.describe();
 
     for (size_t i = 4 * 1024; i <= 256 * 1024 * 1024; i *= 2) {
         size_t iter = 1024;
@@ -127,12 +133,11 @@ int main(int argc, char* argv[]) {
         OCL_CHECK(err, err = q.finish());
 
         /* Execute Kernel */
-        auto start = std::chrono::high_resolution_clock::now();
-        q.enqueueTask(krnl);
-        q.finish();
-        auto end = std::chrono::high_resolution_clock::now();
-        double duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-        double msduration = duration / iter;
+        auto stats = bench.run([&] {
+            q.enqueueTask(krnl);
+            q.finish();
+        });
+        double msduration = stats.mean * 1000000 / iter;
 
         /* Copy results back from OpenCL buffer */
         unsigned char* map_output_buffer0;
@@ -158,6 +163,10 @@ int main(int argc, char* argv[]) {
         std::cout << "Concurrent Read and Write Throughput = " << gbpersec << " (GB/sec) for buffer size " << size_str
                   << std::endl;
 
+        for (auto sample : stats.samples)
+            results.add("Concurrent Read and Write Throughput", "GB/s", {{"buffer_size", bufsize}},
+                        2 * dbytes * iter / sample / ((double)1024 * 1024 * 1024));
+
         if (gbpersec > concurrent_max) {
             concurrent_max = gbpersec;
         }
@@ -167,12 +176,11 @@ int main(int argc, char* argv[]) {
         OCL_CHECK(err, err = krnl_read.setArg(2, iter));
 
         /* Execute Kernel */
-        auto read_start = std::chrono::high_resolution_clock::now();
-        q.enqueueTask(krnl_read);
-        q.finish();
-        auto read_end = std::chrono::high_resolution_clock::now();
-        duration = std::chrono::duration_cast<std::chrono::microseconds>(read_end - read_start).count();
-        msduration = duration / iter;
+        stats = bench.run([&] {
+            q.enqueueTask(krnl_read);
+            q.finish();
+        });
+        msduration = stats.mean * 1000000 / iter;
 
         /* Profiling information */
         dsduration = msduration / ((double)1000000);
@@ -182,6 +190,10 @@ int main(int argc, char* argv[]) {
 
         std::cout << "Read Throughput = " << gbpersec << " (GB/sec) for buffer size " << size_str << std::endl;
 
+        for (auto sample : stats.samples)
+            results.add("Read Throughput", "GB/s", {{"buffer_size", bufsize}},
+                        dbytes * iter / sample / ((double)1024 * 1024 * 1024));
+
         if (gbpersec > read_max) {
             read_max = gbpersec;
         }
@@ -191,12 +203,11 @@ int main(int argc, char* argv[]) {
         OCL_CHECK(err, err = krnl_write.setArg(2, iter));
 
         /* Execute Kernel */
-        auto write_start = std::chrono::high_resolution_clock::now();
-        q.enqueueTask(krnl_write);
-        q.finish();
-        auto write_end = std::chrono::high_resolution_clock::now();
-        duration = std::chrono::duration_cast<std::chrono::microseconds>(write_end - write_start).count();
-        msduration = duration / iter;
+        stats = bench.run([&] {
+            q.enqueueTask(krnl_write);
+            q.finish();
+        });
+        msduration = stats.mean * 1000000 / iter;
 
         /* Profiling information */
         dsduration = msduration / ((double)1000000);
@@ -206,6 +217,10 @@ int main(int argc, char* argv[]) {
 
         std::cout << "Write Throughput = " << gbpersec << " (GB/sec) for buffer size " << size_str << "\n\n";
 
+        for (auto sample : stats.samples)
+            results.add("Write Throughput", "GB/s", {{"buffer_size", bufsize}},
+                        dbytes * iter / sample / ((double)1024 * 1024 * 1024));
+
         if (gbpersec > write_max) {
             write_max = gbpersec;
         }
@@ -218,6 +233,7 @@ int main(int argc, char* argv[]) {
     std::cout << "Concurrent Read and Write Throughput = " << concurrent_max << " (GB/sec) \n";
     std::cout << "Read Throughput = " << read_max << " (GB/sec) \n";
     std::cout << "Write Throughput = " << write_max << " (GB/sec) \n\n";
+    results.write();
     std::cout << "TEST PASSED\n";
     return EXIT_SUCCESS;
 }
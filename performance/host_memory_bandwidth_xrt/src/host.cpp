@@ -15,15 +15,216 @@
 */
 
 #include "xcl2.hpp"
+#include "benchmark.hpp"
 #include "cmdlineparser.h"
+#include "logger.h"
+#include "results.hpp"
+#include "verify.hpp"
+#include "xrt_bufpool.hpp"
+#include <algorithm>
 #include <cstring>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
+#include <time.h>
 
 // XRT includes
 #include "experimental/xrt_bo.h"
 #include "experimental/xrt_device.h"
 #include "experimental/xrt_kernel.h"
 
+// CPU time consumed so far by the process, XRT threads included, in s
+static double process_cpu_seconds() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Clock rate used to turn CPU time into cycles. On x86 this is the rate of
+// the time stamp counter measured against the steady clock, elsewhere the
+// cycles are nanoseconds.
+static double cpu_hz() {
+#if defined(__x86_64__) || defined(__i386__)
+    auto start = std::chrono::steady_clock::now();
+    uint64_t tsc = __builtin_ia32_rdtsc();
+    auto end = start;
+    while (end - start < std::chrono::milliseconds(50)) end = std::chrono::steady_clock::now();
+    tsc = __builtin_ia32_rdtsc() - tsc;
+    return tsc / std::chrono::duration<double>(end - start).count();
+#else
+    return 1e9;
+#endif
+}
+
+// Result of one buffer strategy for one buffer size
+struct strategy_t {
+    double h2c;         // host to card throughput, GB/s
+    double c2h;         // card to host throughput, GB/s
+    double cpu_seconds; // CPU time of the timed transfers in both directions
+    double transfers;   // timed transfers in both directions
+    double first_us;    // allocating the buffer and its first round trip
+    size_t mismatch;    // first byte that did not come back, the size if none
+};
+
+// Moves bufsize bytes of input between the host and the card iter times in
+// each direction with one of the buffer strategies:
+//   sync      a normal BO in device memory bank, filled through its mapping
+//             and moved with bo.sync()
+//   userptr   a BO wrapping application memory from aligned_allocator,
+//             moved with bo.sync() without any host side copy
+//   host_only a host_only BO the read_bandwidth and write_bandwidth kernels
+//             access directly through the host memory bridge
+//   copy      a normal BO in device memory bank, written and read with
+//             bo.write() and bo.read() around bo.sync()
+// The first touch cost is the time to allocate the buffer and make its first
+// round trip, page faults and pinning included.
+static strategy_t run_strategy(const std::string& strategy,
+                               xrt::device& device,
+                               xrt::kernel& krnl_read,
+                               xrt::kernel& krnl_write,
+                               int bank,
+                               const unsigned char* input,
+                               size_t bufsize,
+                               size_t iter,
+                               xcl::Benchmark& bench) {
+    std::vector<unsigned char, aligned_allocator<unsigned char> > data;
+    std::vector<unsigned char> output(bufsize);
+    xrt::bo bo;
+    unsigned char* map = nullptr;
+    strategy_t result;
+
+    auto to_device = [&] {
+        if (strategy == "copy") bo.write(input);
+        bo.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+    };
+    auto from_device = [&] {
+        bo.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
+        if (strategy == "copy") bo.read(output.data());
+    };
+
+    // First touch
+    auto start = std::chrono::high_resolution_clock::now();
+    if (strategy == "sync") {
+        bo = xrt::bo(device, bufsize, bank);
+        map = bo.map<unsigned char*>();
+        std::copy(input, input + bufsize, map);
+        to_device();
+        from_device();
+    } else if (strategy == "userptr") {
+        data.assign(input, input + bufsize);
+        bo = xrt::bo(device, data.data(), bufsize, bank);
+        to_device();
+        from_device();
+    } else if (strategy == "host_only") {
+        bo = xrt::bo(device, bufsize, xrt::bo::flags::host_only, krnl_read.group_id(0));
+        map = bo.map<unsigned char*>();
+        std::copy(input, input + bufsize, map);
+        krnl_read(bo, bufsize, 1).wait();
+        krnl_write(bo, bufsize, 1).wait();
+    } else {
+        bo = xrt::bo(device, bufsize, bank);
+        to_device();
+        from_device();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    result.first_us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+    // Steady state, each direction repeated by the benchmark harness
+    double gb = (double)bufsize * iter / ((double)1024 * 1024 * 1024);
+    size_t runs = 0;
+    double cpu = process_cpu_seconds();
+    auto h2c = bench.run([&] {
+        if (strategy == "host_only") {
+            krnl_read(bo, bufsize, iter).wait();
+        } else {
+            for (size_t i = 0; i < iter; i++) to_device();
+        }
+        runs++;
+    });
+    result.h2c = gb / h2c.mean;
+
+    if (strategy != "host_only") {
+        // Clear the host side so the check below sees what came back
+        if (map) std::fill(map, map + bufsize, 0);
+        if (!data.empty()) std::fill(data.begin(), data.end(), 0);
+    }
+    auto c2h = bench.run([&] {
+        if (strategy == "host_only") {
+            krnl_write(bo, bufsize, iter).wait();
+        } else {
+            for (size_t i = 0; i < iter; i++) from_device();
+        }
+        runs++;
+    });
+    result.c2h = gb / c2h.mean;
+    result.cpu_seconds = process_cpu_seconds() - cpu;
+    result.transfers = (double)runs * iter;
+
+    // The kernels of host_only do not move the data back, the others must
+    // return the input unchanged
+    result.mismatch = bufsize;
+    if (strategy != "host_only") {
+        const unsigned char* back = map ? map : (!data.empty() ? data.data() : output.data());
+        result.mismatch = xcl::first_mismatch(input, back, bufsize);
+    }
+    return result;
+}
+
+// Runs every buffer size through each of the strategies and prints their
+// throughput, CPU cost and first touch cost side by side
+static int compare_strategies(const std::vector<std::string>& strategies,
+                              xrt::device& device,
+                              xrt::kernel& krnl_read,
+                              xrt::kernel& krnl_write,
+                              int bank,
+                              const std::vector<uint64_t>& sizes,
+                              xcl::Benchmark& bench,
+                              xcl::Results& results) {
+    double hz = cpu_hz();
+    std::cout << "CPU cycles counted at " << hz / 1e9 << " GHz\n";
+    for (auto size : sizes) {
+        size_t bufsize = size;
+        size_t iter = std::max<size_t>((64 * 1024 * 1024) / bufsize, 1);
+        if (xcl::is_emulation()) iter = 2;
+
+        std::vector<unsigned char> input(bufsize);
+        for (size_t i = 0; i < bufsize; i++) input[i] = i % 256;
+
+        std::cout << "\nBuffer size " << xcl::convert_size(bufsize) << ", " << iter << " transfers\n";
+        std::cout << std::left << std::setw(12) << "Strategy" << std::right << std::setw(12) << "H2C GB/s"
+                  << std::setw(12) << "C2H GB/s" << std::setw(12) << "cycles/B" << std::setw(18) << "first touch us"
+                  << "\n";
+        for (auto& strategy : strategies) {
+            TraceScope(strategy.c_str());
+            strategy_t result;
+            try {
+                result = run_strategy(strategy, device, krnl_read, krnl_write, bank, input.data(), bufsize, iter,
+                                      bench);
+            } catch (const std::exception& e) {
+                // Typically the device memory bank is not used by the xclbin
+                std::cout << std::left << std::setw(12) << strategy << std::right << "skipped: " << e.what() << "\n";
+                continue;
+            }
+            double cycles_per_byte = result.cpu_seconds * hz / (result.transfers * bufsize);
+            std::cout << std::left << std::setw(12) << strategy << std::right << std::fixed << std::setprecision(3)
+                      << std::setw(12) << result.h2c << std::setw(12) << result.c2h << std::setw(12)
+                      << cycles_per_byte << std::setprecision(1) << std::setw(18) << result.first_us
+                      << std::defaultfloat << std::setprecision(6) << "\n";
+            xcl::Results::Params params = {{"strategy", strategy}, {"buffer_size", bufsize}};
+            results.add("Host to Card Throughput", "GB/s", params, result.h2c);
+            results.add("Card to Host Throughput", "GB/s", params, result.c2h);
+            results.add("CPU Cycles per Byte", "cycles/B", params, cycles_per_byte, xcl::Results::LOWER);
+            results.add("First Touch", "us", params, result.first_us, xcl::Results::LOWER);
+            if (result.mismatch != bufsize)
+                throw std::runtime_error("Value read back by " + strategy + " does not match reference at byte " +
+                                         std::to_string(result.mismatch));
+        }
+    }
+    results.write();
+    std::cout << "\nTEST PASSED\n";
+    return EXIT_SUCCESS;
+}
+
 int main(int argc, char* argv[]) {
     // Command Line Parser
     sda::utils::CmdLineParser parser;
@@ -32,6 +233,10 @@ int main(int argc, char* argv[]) {
     //**************//"<Full Arg>",  "<Short Arg>", "<Description>", "<Default>"
     parser.addSwitch("--xclbin_file", "-x", "input binary file string", "");
     parser.addSwitch("--device_id", "-d", "device index", "0");
+    parser.addSwitch("--sizes", "-s", "buffer sizes, a list or range such as 4K..64M:x2", "4K..64M:x2");
+    parser.addSwitch("--strategies", "-m", "compare buffer strategies: all or a list of sync,userptr,host_only,copy",
+                     "");
+    parser.addSwitch("--bank", "-b", "device memory bank of the sync, userptr and copy strategies", "0");
     parser.parse(argc, argv);
 
     // Read settings
@@ -43,26 +248,73 @@ int main(int argc, char* argv[]) {
         return EXIT_FAILURE;
     }
 
+    std::vector<uint64_t> sizes = parser.value_to_list("sizes");
+    if (sizes.empty()) {
+        parser.printHelp();
+        return EXIT_FAILURE;
+    }
+    if (xcl::is_emulation()) {
+        std::vector<uint64_t> emu_sizes;
+        for (auto size : sizes) {
+            if (size <= 8 * 1024) emu_sizes.push_back(size);
+        }
+        sizes = emu_sizes;
+    }
+
     std::cout << "Open the device" << device_index << std::endl;
     auto device = xrt::device(device_index);
     std::cout << "Load the xclbin " << binaryFile << std::endl;
+    TraceBegin("load_xclbin");
     auto uuid = device.load_xclbin(binaryFile);
+    TraceEnd("load_xclbin");
 
     auto krnl = xrt::kernel(device, uuid, "bandwidth");
     auto krnl_read = xrt::kernel(device, uuid, "read_bandwidth");
     auto krnl_write = xrt::kernel(device, uuid, "write_bandwidth");
 
+    xcl::Results results("host_memory_bandwidth_xrt");
+    // Every throughput is the mean of repeated runs after a warmup run
+    xcl::Benchmark bench;
+    bench.describe();
+
+    std::string strategy_list = parser.value("strategies");
+    if (!strategy_list.empty()) {
+        if (strategy_list == "all") strategy_list = "sync,userptr,host_only,copy";
+        std::vector<std::string> strategies;
+        std::stringstream ss(strategy_list);
+        for (std::string strategy; std::getline(ss, strategy, ',');) {
+            if (strategy != "sync" && strategy != "userptr" && strategy != "host_only" && strategy != "copy") {
+                std::cout << "Error: Unknown buffer strategy " << strategy << std::endl;
+                parser.printHelp();
+                return EXIT_FAILURE;
+            }
+            strategies.push_back(strategy);
+        }
+        return compare_strategies(strategies, device, krnl_read, krnl_write, stoi(parser.value("bank")), sizes,
+                                  bench, results);
+    }
+
+    // Create and pin every host_only buffer before the sweep, the loop below
+    // then only leases buffers that already exist.
+    uint64_t flags = static_cast<uint64_t>(xrt::bo::flags::host_only);
+    xcl::XrtBoPool pool{xcl::XrtBoAllocator(device)};
+    TraceBegin("prewarm");
+    for (auto size : sizes) {
+        pool.prewarm(size, krnl.group_id(0), flags, 1);
+        pool.prewarm(size, krnl.group_id(1), flags, 1);
+    }
+    TraceEnd("prewarm");
+
     double concurrent_max = 0;
     double read_max = 0;
     double write_max = 0;
 
-    for (size_t i = 4 * 1024; i <= 64 * 1024 * 1024; i *= 2) {
-        size_t iter = (64 * 1024 * 1024) / i;
-        size_t bufsize = i;
+    for (auto size : sizes) {
+        size_t bufsize = size;
+        size_t iter = std::max<size_t>((64 * 1024 * 1024) / bufsize, 1);
 
         if (xcl::is_emulation()) {
             iter = 2;
-            if (bufsize > 8 * 1024) break;
         }
 
         /* Input buffer */
@@ -77,9 +329,10 @@ int main(int argc, char* argv[]) {
             input_host[i] = i % 256;
         }
 
-        xrt::bo::flags flags = xrt::bo::flags::host_only;
-        auto hostonly_bo_in = xrt::bo(device, bufsize, flags, krnl.group_id(0));
-        auto hostonly_bo_out = xrt::bo(device, bufsize, flags, krnl.group_id(1));
+        auto lease_in = pool.lease(bufsize, krnl.group_id(0), flags);
+        auto lease_out = pool.lease(bufsize, krnl.group_id(1), flags);
+        auto& hostonly_bo_in = lease_in.get();
+        auto& hostonly_bo_out = lease_out.get();
 
         double dbytes = bufsize;
         std::string size_str = xcl::convert_size(bufsize);
@@ -88,6 +341,7 @@ int main(int argc, char* argv[]) {
         auto bo_in_map = hostonly_bo_in.map<char*>();
         auto bo_out_map = hostonly_bo_out.map<char*>();
 
+        TraceBegin("fill");
         std::fill(bo_in_map, bo_in_map + bufsize, 0);
         std::fill(bo_out_map, bo_out_map + bufsize, 0);
 
@@ -95,17 +349,19 @@ int main(int argc, char* argv[]) {
         for (size_t i = 0; i < bufsize; ++i) {
             bo_in_map[i] = input_host[i];
         }
+        TraceEnd("fill");
 
-        auto start = std::chrono::high_resolution_clock::now();
-        auto run = krnl(hostonly_bo_in, hostonly_bo_out, bufsize, iter);
-        run.wait();
-        auto end = std::chrono::high_resolution_clock::now();
-        double duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-        double msduration = duration / iter;
+        TraceBegin("bandwidth");
+        auto stats = bench.run([&] { krnl(hostonly_bo_in, hostonly_bo_out, bufsize, iter).wait(); });
+        TraceEnd("bandwidth");
+        double msduration = stats.mean * 1000000 / iter;
 
         // Validate our results
-        if (std::memcmp(bo_out_map, bo_in_map, bufsize))
-            throw std::runtime_error("Value read back does not match reference");
+        TraceBegin("verify");
+        size_t offset = xcl::first_mismatch(bo_in_map, bo_out_map, bufsize);
+        if (offset != bufsize)
+            throw std::runtime_error("Value read back does not match reference at byte " + std::to_string(offset));
+        TraceEnd("verify");
 
         /* Profiling information */
         double dsduration = msduration / ((double)1000000);
@@ -115,16 +371,18 @@ int main(int argc, char* argv[]) {
         std::cout << "Concurrent Read and Write Throughput = " << gbpersec << " (GB/sec) for buffer size " << size_str
                   << std::endl;
 
+        for (auto sample : stats.samples)
+            results.add("Concurrent Read and Write Throughput", "GB/s", {{"buffer_size", bufsize}},
+                        2 * dbytes * iter / sample / ((double)1024 * 1024 * 1024));
+
         if (gbpersec > concurrent_max) {
             concurrent_max = gbpersec;
         }
 
-        start = std::chrono::high_resolution_clock::now();
-        auto run_read = krnl_read(hostonly_bo_in, bufsize, iter);
-        run_read.wait();
-        end = std::chrono::high_resolution_clock::now();
-        duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-        msduration = duration / iter;
+        TraceBegin("read_bandwidth");
+        stats = bench.run([&] { krnl_read(hostonly_bo_in, bufsize, iter).wait(); });
+        TraceEnd("read_bandwidth");
+        msduration = stats.mean * 1000000 / iter;
 
         /* Profiling information */
         dsduration = msduration / ((double)1000000);
@@ -133,16 +391,18 @@ int main(int argc, char* argv[]) {
 
         std::cout << "Read Throughput = " << gbpersec << " (GB/sec) for buffer size " << size_str << std::endl;
 
+        for (auto sample : stats.samples)
+            results.add("Read Throughput", "GB/s", {{"buffer_size", bufsize}},
+                        dbytes * iter / sample / ((double)1024 * 1024 * 1024));
+
         if (gbpersec > read_max) {
             read_max = gbpersec;
         }
 
-        start = std::chrono::high_resolution_clock::now();
-        auto run_write = krnl_write(hostonly_bo_out, bufsize, iter);
-        run_write.wait();
-        end = std::chrono::high_resolution_clock::now();
-        duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-        msduration = duration / iter;
+        TraceBegin("write_bandwidth");
+        stats = bench.run([&] { krnl_write(hostonly_bo_out, bufsize, iter).wait(); });
+        TraceEnd("write_bandwidth");
+        msduration = stats.mean * 1000000 / iter;
 
         /* Profiling information */
         dsduration = msduration / ((double)1000000);
@@ -151,6 +411,10 @@ int main(int argc, char* argv[]) {
 
         std::cout << "Write Throughput = " << gbpersec << " (GB/sec) for buffer size " << size_str << "\n\n";
 
+        for (auto sample : stats.samples)
+            results.add("Write Throughput", "GB/s", {{"buffer_size", bufsize}},
+                        dbytes * iter / sample / ((double)1024 * 1024 * 1024));
+
         if (gbpersec > write_max) {
             write_max = gbpersec;
         }
@@ -160,6 +424,7 @@ int main(int argc, char* argv[]) {
     std::cout << "Concurrent Read and Write Throughput = " << concurrent_max << " (GB/sec) \n";
     std::cout << "Read Throughput = " << read_max << " (GB/sec) \n";
     std::cout << "Write Throughput = " << write_max << " (GB/sec) \n\n";
+    results.write();
     std::cout << "TEST PASSED\n";
     return EXIT_SUCCESS;
 }
@@ -14,17 +14,213 @@
 * under the License.
 */
 
+#include "benchmark.hpp"
 #include "cmdlineparser.h"
+#include "histogram.hpp"
+#include "logger.h"
+#include "results.hpp"
 #include <iostream>
 #include <iomanip>
+#include <map>
 #include <vector>
 #include <chrono>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <time.h>
 #include "xcl2.hpp"
+#include "xrt_bufpool.hpp"
 
 #include "experimental/xrt_device.h"
 #include "experimental/xrt_bo.h"
 #include "experimental/xrt_kernel.h"
 
+typedef std::chrono::high_resolution_clock clock_type;
+
+// Prints the latency percentiles of a histogram of ns samples in us
+static void print_latency(const xcl::Histogram& hist) {
+    std::streamsize precision = std::cout.precision();
+    std::cout << std::fixed << std::setprecision(1) << " latency us: p50 " << hist.percentile(50) / 1000.0 << " p90 "
+              << hist.percentile(90) / 1000.0 << " p99 " << hist.percentile(99) / 1000.0 << " p99.9 "
+              << hist.percentile(99.9) / 1000.0 << " max " << hist.max() / 1000.0 << std::defaultfloat
+              << std::setprecision(precision) << std::endl;
+}
+
+// Records the latency percentiles of a histogram of ns samples in us
+static void add_latency(xcl::Results& results, const xcl::Results::Params& params, const xcl::Histogram& hist) {
+    results.add("Latency p50", "us", params, hist.percentile(50) / 1000.0, xcl::Results::LOWER);
+    results.add("Latency p99", "us", params, hist.percentile(99) / 1000.0, xcl::Results::LOWER);
+    results.add("Latency p99.9", "us", params, hist.percentile(99.9) / 1000.0, xcl::Results::LOWER);
+}
+
+// FIFO of command slots handed between the issuing and the waiting thread
+class SlotQueue {
+   public:
+    void push(size_t slot) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_slots.push_back(slot);
+        }
+        m_cv.notify_one();
+    }
+    size_t pop() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this] { return !m_slots.empty(); });
+        size_t slot = m_slots.front();
+        m_slots.pop_front();
+        return slot;
+    }
+
+   private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<size_t> m_slots;
+};
+
+// Issues num_cmds commands at the given rate, with constant or exponential
+// (Poisson process) gaps, whether or not earlier ones have completed. The
+// latency of a command is taken from its scheduled arrival to the return of
+// its wait(), so time spent waiting for a free command slot is included
+// instead of silently lowering the offered load. Returns the achieved rate.
+static double open_loop(std::vector<xrt::run>& cmds,
+                        double rate,
+                        bool poisson,
+                        uint64_t num_cmds,
+                        xcl::Histogram& hist) {
+    SlotQueue free_slots, in_flight;
+    for (size_t i = 0; i < cmds.size(); i++) free_slots.push(i);
+    std::vector<clock_type::time_point> arrival(cmds.size());
+    clock_type::time_point last_done;
+
+    // Waits for the commands in issue order and recycles their slots
+    std::thread waiter([&] {
+        for (uint64_t n = 0; n < num_cmds; n++) {
+            size_t slot = in_flight.pop();
+            cmds[slot].wait();
+            last_done = clock_type::now();
+            hist.record(std::chrono::duration_cast<std::chrono::nanoseconds>(last_done - arrival[slot]).count());
+            free_slots.push(slot);
+        }
+    });
+
+    std::mt19937_64 gen(42);
+    std::exponential_distribution<double> gap(rate);
+    auto start = clock_type::now();
+    double t = 0; // scheduled arrival in s after start
+    for (uint64_t n = 0; n < num_cmds; n++) {
+        auto due = start + std::chrono::nanoseconds((int64_t)(t * 1e9));
+        // Spin, sleeping is too coarse for the gaps at high rates
+        while (clock_type::now() < due) std::this_thread::yield();
+        size_t slot = free_slots.pop();
+        arrival[slot] = due;
+        cmds[slot].start();
+        in_flight.push(slot);
+        t += poisson ? gap(gen) : 1 / rate;
+    }
+    waiter.join();
+
+    double duration = std::chrono::duration_cast<std::chrono::microseconds>(last_done - start).count();
+    return num_cmds * 1000.0 * 1000.0 / duration;
+}
+
+// CPU time consumed so far by the calling thread, in us
+static double thread_cpu_us() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// A command of the threaded mode, owned by its submitter while idle and by
+// the poller while in flight
+struct slot_t {
+    std::atomic<bool> in_flight;
+    clock_type::time_point started;
+};
+
+// Runs num_cmds commands from num_threads submitter threads, each owning an
+// equal slice of cmds that it reuses as a ring. A submitter waits for
+// batch slots of its slice to be idle and starts them back to back. A
+// single poller thread checks the state of the commands in flight instead
+// of blocking in wait(), records their latency and hands the slots back.
+// Prints the IOPS, the latency and the CPU time per command of the
+// submitters and of the poller, and returns the IOPS.
+static double threaded(
+    std::vector<xrt::run>& cmds, int num_threads, int batch, uint64_t num_cmds, xcl::Results& results) {
+    size_t slice = cmds.size() / num_threads;
+    std::vector<slot_t> slots(num_threads * slice);
+    for (auto& slot : slots) slot.in_flight = false;
+    std::atomic<uint64_t> completed(0);
+    std::vector<double> submit_cpu(num_threads);
+    double poll_cpu = 0;
+    xcl::Histogram hist;
+
+    auto start = clock_type::now();
+    std::thread poller([&] {
+        double cpu = thread_cpu_us();
+        uint64_t done = 0;
+        while (done < num_cmds) {
+            for (size_t i = 0; i < slots.size(); i++) {
+                if (!slots[i].in_flight.load(std::memory_order_acquire)) continue;
+                if (cmds[i].state() != ERT_CMD_STATE_COMPLETED) continue;
+                hist.record(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - slots[i].started).count());
+                slots[i].in_flight.store(false, std::memory_order_release);
+                done++;
+            }
+        }
+        completed = done;
+        poll_cpu = thread_cpu_us() - cpu;
+    });
+
+    std::vector<std::thread> submitters;
+    for (int t = 0; t < num_threads; t++) {
+        submitters.emplace_back([&, t] {
+            double cpu = thread_cpu_us();
+            size_t begin = t * slice;
+            size_t i = 0;
+            uint64_t quota = num_cmds / num_threads + ((uint64_t)t < num_cmds % num_threads ? 1 : 0);
+            std::vector<size_t> ready;
+            for (uint64_t issued = 0; issued < quota; issued += ready.size()) {
+                // Collect the next slots of the ring once they are idle
+                ready.clear();
+                size_t n = std::min<uint64_t>(batch, quota - issued);
+                while (ready.size() < n) {
+                    while (slots[begin + i].in_flight.load(std::memory_order_acquire)) std::this_thread::yield();
+                    ready.push_back(begin + i);
+                    if (++i == slice) i = 0;
+                }
+                for (auto j : ready) {
+                    slots[j].started = clock_type::now();
+                    cmds[j].start();
+                    slots[j].in_flight.store(true, std::memory_order_release);
+                }
+            }
+            submit_cpu[t] = thread_cpu_us() - cpu;
+        });
+    }
+    for (auto& submitter : submitters) submitter.join();
+    poller.join();
+    auto end = clock_type::now();
+
+    double duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    double iops = completed * 1000.0 * 1000.0 / duration;
+    double submit = 0;
+    for (auto cpu : submit_cpu) submit += cpu;
+    std::cout << "Threads: " << std::setw(3) << num_threads << " batch: " << std::setw(4) << batch
+              << " iops: " << iops;
+    print_latency(hist);
+    std::cout << "  CPU us per command: submit " << submit / completed << " poll " << poll_cpu / completed
+              << " total " << (submit + poll_cpu) / completed << std::endl;
+    xcl::Results::Params params = {{"threads", num_threads}, {"batch", batch}, {"cmds", num_cmds}};
+    results.add("IOPS", "cmds/s", params, iops);
+    add_latency(results, params, hist);
+    results.add("CPU per Command", "us", params, (submit + poll_cpu) / completed, xcl::Results::LOWER);
+    return iops;
+}
+
 int main(int argc, char* argv[]) {
     // Command Line Parser
     sda::utils::CmdLineParser parser;
@@ -33,6 +229,13 @@ int main(int argc, char* argv[]) {
     //**************//"<Full Arg>",  "<Short Arg>", "<Description>", "<Default>"
     parser.addSwitch("--xclbin_file", "-x", "input binary file string", "");
     parser.addSwitch("--device_id", "-d", "device index", "0");
+    parser.addSwitch("--cmds", "-c", "commands per run, a list or range",
+                     "10,50,100,200,500,1000,1500,2000,3000,5000,10000,50000,100000,500000,1000000");
+    parser.addSwitch("--rates", "-r", "open loop mode, offered rates in commands/s, a list or range", "");
+    parser.addSwitch("--arrival", "-a", "open loop arrivals, poisson or constant", "poisson");
+    parser.addSwitch("--duration", "-t", "open loop time per rate, in ms", "1000");
+    parser.addSwitch("--threads", "-k", "threaded mode, submitter threads, a list or range", "");
+    parser.addSwitch("--batch", "-b", "threaded mode, commands started together, a list or range", "1");
     parser.parse(argc, argv);
 
     // Read settings
@@ -47,60 +250,147 @@ int main(int argc, char* argv[]) {
     std::cout << "Open the device" << device_index << std::endl;
     auto device = xrt::device(device_index);
     std::cout << "Load the xclbin " << binaryFile << std::endl;
+    TraceBegin("load_xclbin");
     auto uuid = device.load_xclbin(binaryFile);
+    TraceEnd("load_xclbin");
 
     /* The command would incease */
-    std::vector<unsigned int> cmds_per_run = {10,   50,   100,   200,   500,    1000,   1500,   2000,
-                                              3000, 5000, 10000, 50000, 100000, 500000, 1000000};
+    std::vector<uint64_t> cmds_per_run = parser.value_to_list("cmds");
+    std::vector<uint64_t> rates;
+    if (!parser.value("rates").empty()) rates = parser.value_to_list("rates");
+    std::string arrival = parser.value("arrival");
+    int duration_ms = parser.value_to_int("duration");
+    if (cmds_per_run.empty() || (!parser.value("rates").empty() && rates.empty()) ||
+        (arrival != "poisson" && arrival != "constant") || duration_ms < 1) {
+        parser.printHelp();
+        return EXIT_FAILURE;
+    }
     int expected_cmds = 10000;
 
     if (xcl::is_emulation()) {
         cmds_per_run = {10, 20};
+        if (!rates.empty()) rates = {10, 20};
+        duration_ms = 1000;
         std::cout << "Number of operations is reduced for faster execution on "
                      "emulation flow.\n";
         expected_cmds = 20;
     }
     auto hello = xrt::kernel(device, uuid.get(), "hello");
+    xcl::Results results("iops_test_xrt");
 
     /* Create 'expected_cmds' commands if possible */
+    uint64_t flags = static_cast<uint64_t>(xrt::bo::flags::normal);
+    TraceBegin("create_commands");
+    xcl::XrtBoPool pool{xcl::XrtBoAllocator(device)};
+    pool.prewarm(20, hello.group_id(0), flags, expected_cmds);
+
     std::vector<xrt::run> cmds;
-    std::vector<xrt::bo> bos;
+    std::vector<xcl::XrtBoPool::Lease> bos;
     for (int i = 0; i < expected_cmds; i++) {
         auto run = xrt::run(hello);
-        auto bo = xrt::bo(device, 20, hello.group_id(0));
-        run.set_arg(0, bo);
+        auto bo = pool.lease(20, hello.group_id(0), flags);
+        run.set_arg(0, bo.get());
         cmds.push_back(std::move(run));
         bos.push_back(std::move(bo));
     }
+    TraceEnd("create_commands");
     std::cout << "Allocated commands, expect " << expected_cmds << ", created " << cmds.size() << std::endl;
 
-    for (auto num_cmds : cmds_per_run) {
-        uint32_t i = 0;
-        unsigned int issued = 0, completed = 0;
-        auto start = std::chrono::high_resolution_clock::now();
+    // Threaded mode: IOPS against the number of submitter threads
+    if (!parser.value("threads").empty()) {
+        auto sweep = parser.sweep({"threads", "batch"});
+        uint64_t num_cmds = *std::max_element(cmds_per_run.begin(), cmds_per_run.end());
+        if (sweep.size() == 0) {
+            parser.printHelp();
+            return EXIT_FAILURE;
+        }
+        std::map<uint64_t, double> base; // iops of the first thread count, by batch
+        for (auto point : sweep) {
+            TraceScope("threads");
+            uint64_t threads = point["threads"];
+            uint64_t batch = point["batch"];
+            if (threads < 1 || batch < 1 || cmds.size() / threads < batch) {
+                std::cout << "Skipping " << threads << " threads with batch " << batch << ", "
+                          << cmds.size() / std::max<uint64_t>(threads, 1) << " commands per thread" << std::endl;
+                continue;
+            }
+            double iops = threaded(cmds, threads, batch, num_cmds, results);
+            if (base.count(batch) == 0) base[batch] = iops;
+            std::cout << "  Scaling: " << iops / base[batch] << "x the IOPS of the first thread count" << std::endl;
+        }
+        results.write();
+        std::cout << "TEST PASSED\n";
+        return 0;
+    }
 
-        for (auto& cmd : cmds) {
-            cmd.start();
-            if (++issued == num_cmds) break;
+    // Open loop mode: latency against offered load
+    if (!rates.empty()) {
+        uint64_t saturation = 0;
+        for (auto rate : rates) {
+            TraceScope("rate");
+            xcl::Histogram hist;
+            uint64_t num_cmds = std::max<uint64_t>(1, rate * duration_ms / 1000);
+            double achieved = open_loop(cmds, rate, arrival == "poisson", num_cmds, hist);
+            std::cout << "Offered: " << std::setw(7) << rate << " cmds/s achieved: " << achieved;
+            print_latency(hist);
+            xcl::Results::Params params = {{"rate", rate}, {"arrival", arrival}};
+            results.add("Achieved Rate", "cmds/s", params, achieved);
+            add_latency(results, params, hist);
+            // The load is served as long as the achieved rate keeps up
+            if (achieved >= 0.95 * rate) saturation = std::max(saturation, rate);
         }
+        if (saturation)
+            std::cout << "Saturation point: " << saturation << " cmds/s, the highest offered rate served within 5%"
+                      << std::endl;
+        else
+            std::cout << "Saturation point: below the lowest offered rate" << std::endl;
+        results.add("Saturation Point", "cmds/s", {{"arrival", arrival}}, saturation);
+        results.write();
+        std::cout << "TEST PASSED\n";
+        return 0;
+    }
 
-        while (completed < num_cmds) {
-            cmds[i].wait();
+    // Every number of commands is run repeatedly until its mean duration is
+    // stable, the latencies are those of the last run
+    xcl::Benchmark bench;
+    bench.describe();
+    std::vector<clock_type::time_point> started(cmds.size());
+    for (auto num_cmds : cmds_per_run) {
+        TraceScope("batch");
+        xcl::Histogram hist;
+        auto stats = bench.run([&] {
+            uint32_t i = 0;
+            unsigned int issued = 0, completed = 0;
+            hist.reset();
 
-            completed++;
-            if (issued < num_cmds) {
-                cmds[i].start();
-                issued++;
+            for (auto& cmd : cmds) {
+                started[issued] = clock_type::now();
+                cmd.start();
+                if (++issued == num_cmds) break;
             }
 
-            if (++i == cmds.size()) i = 0;
-        }
+            while (completed < num_cmds) {
+                cmds[i].wait();
+                auto done = clock_type::now();
+                hist.record(std::chrono::duration_cast<std::chrono::nanoseconds>(done - started[i]).count());
+
+                completed++;
+                if (issued < num_cmds) {
+                    started[i] = done;
+                    cmds[i].start();
+                    issued++;
+                }
+
+                if (++i == cmds.size()) i = 0;
+            }
+        });
 
-        auto end = std::chrono::high_resolution_clock::now();
-        double duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-        std::cout << "Commands: " << std::setw(7) << num_cmds << " iops: " << (num_cmds * 1000.0 * 1000.0 / duration)
-                  << std::endl;
+        std::cout << "Commands: " << std::setw(7) << num_cmds << " iops: " << (num_cmds / stats.mean);
+        print_latency(hist);
+        for (auto sample : stats.samples) results.add("IOPS", "cmds/s", {{"cmds", num_cmds}}, num_cmds / sample);
+        add_latency(results, {{"cmds", num_cmds}}, hist);
     }
+    results.write();
     std::cout << "TEST PASSED\n";
     return 0;
 }
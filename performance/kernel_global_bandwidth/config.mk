@@ -22,6 +22,7 @@ endif
 endif
 endif
 
+# Only the kernel ports depend on the bank count, the host reads the banks
+# from the xclbin
 VPP_FLAGS += -DNDDR_BANKS=$(ddr_banks)
 
-CXXFLAGS += -DNDDR_BANKS=$(ddr_banks)
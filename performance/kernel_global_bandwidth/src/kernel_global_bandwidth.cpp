@@ -37,7 +37,7 @@
 *     --config ../src/<config_file>.cfg
 *  3. Default number of banks for CLI flow is 2 banks, for GUI flow is 1 bank.
 *     For 3 or 4 DDR connections, "#define NDDR_BANKS <3 or 4>" at the top of
-*kernel.cpp
+*kernel.cpp. The host reads the banks from the xclbin and needs no change.
 * *****************************************************************************************
 *
 *  CLI Flow:
@@ -50,16 +50,71 @@
 *
 *********************************************************************************************/
 
+#include "benchmark.hpp"
+#include "results.hpp"
+#include "verify.hpp"
 #include "xcl2.hpp"
+#include "xclbin.h"
+#include <map>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <vector>
 
-#ifndef NDDR_BANKS
-#define NDDR_BANKS 1
-#endif
+// A buffer argument of the bandwidth kernel and the memory bank it is
+// connected to in the xclbin
+struct port_t {
+    int arg;          // kernel argument index
+    std::string name; // input0, output0, ...
+    bool input;       // read by the kernel, written by the host
+    int bank;         // memory topology index
+    std::string tag;  // DDR[0], bank0, ...
+    cl::Buffer buffer;
+    unsigned char* map;
+};
+
+// Returns the section of the given kind of an xclbin, or nullptr if it is
+// missing or does not fit into the file
+static const unsigned char* find_section(const xcl::BinaryView& xclbin, axlf_section_kind kind) {
+    const axlf* top = (const axlf*)xclbin.data();
+    if (xclbin.size() < sizeof(axlf) || strncmp(top->m_magic, "xclbin2", 8) != 0) return nullptr;
+    for (uint32_t i = 0; i < top->m_header.m_numSections; i++) {
+        const axlf_section_header& section = top->m_sections[i];
+        if ((const unsigned char*)(&section + 1) > xclbin.data() + xclbin.size()) return nullptr;
+        if (section.m_sectionKind != (uint32_t)kind) continue;
+        if (section.m_sectionOffset + section.m_sectionSize > xclbin.size()) return nullptr;
+        return xclbin.data() + section.m_sectionOffset;
+    }
+    return nullptr;
+}
+
+// Reads the memory bank index and tag of every argument of the first
+// compute unit of kernel from the IP_LAYOUT, CONNECTIVITY and MEM_TOPOLOGY
+// sections of the xclbin, keyed by argument index
+static std::map<int, std::pair<int, std::string> > get_arg_banks(const xcl::BinaryView& xclbin,
+                                                                 const std::string& kernel) {
+    std::map<int, std::pair<int, std::string> > banks;
+    auto ips = (const ip_layout*)find_section(xclbin, IP_LAYOUT);
+    auto conns = (const connectivity*)find_section(xclbin, CONNECTIVITY);
+    auto topology = (const mem_topology*)find_section(xclbin, MEM_TOPOLOGY);
+    if (ips == nullptr || conns == nullptr || topology == nullptr) return banks;
+
+    // compute units are named <kernel>:<kernel>_<n>
+    std::string prefix = kernel + ":";
+    int cu = -1;
+    for (int i = 0; i < ips->m_count && cu < 0; i++) {
+        if (strncmp((const char*)ips->m_ip_data[i].m_name, prefix.c_str(), prefix.size()) == 0) cu = i;
+    }
+    for (int i = 0; i < conns->m_count; i++) {
+        const connection& c = conns->m_connection[i];
+        if (c.m_ip_layout_index != cu || c.mem_data_index < 0 || c.mem_data_index >= topology->m_count) continue;
+        const mem_data& mem = topology->m_mem_data[c.mem_data_index];
+        std::string tag((const char*)mem.m_tag, strnlen((const char*)mem.m_tag, sizeof(mem.m_tag)));
+        banks[c.arg_index] = std::make_pair(c.mem_data_index, tag);
+    }
+    return banks;
+}
 
 int main(int argc, char** argv) {
     if (argc != 2) {
@@ -74,10 +129,10 @@ int main(int argc, char** argv) {
     cl::Context context;
     cl::Kernel krnl_global_bandwidth;
     auto devices = xcl::get_xil_devices();
-    // read_binary_file() is a utility API which will load the binaryFile
-    // and will return the pointer to file buffer.
-    auto fileBuf = xcl::read_binary_file(binaryFile);
-    cl::Program::Binaries bins{{fileBuf.data(), fileBuf.size()}};
+    // map_binary_file() is a utility API which will map the binaryFile
+    // and will return a view of the file buffer.
+    auto fileBuf = xcl::map_binary_file(binaryFile);
+    cl::Program::Binaries bins{{fileBuf->data(), fileBuf->size()}};
     bool valid_device = false;
     for (unsigned int i = 0; i < devices.size(); i++) {
         auto device = devices[i];
@@ -119,35 +174,40 @@ int main(int argc, char** argv) {
         return EXIT_FAILURE;
     }
 
-    for (size_t i = 0; i < globalbuffersize; i++) {
-        input_host[i] = i % 256;
-    }
-
-    short ddr_banks = NDDR_BANKS;
-
-    /* Index for the ddr pointer array: 4=4, 3=3, 2=2, 1=2 */
-    char num_buffers = ddr_banks;
-    if (ddr_banks == 1) num_buffers = ddr_banks + (ddr_banks % 2);
-
-    /* buffer[0] is input0
-     * buffer[1] is output0
-     * buffer[2] is input1
-     * buffer[3] is output1 */
-    cl::Buffer* buffer[num_buffers];
-
-#if NDDR_BANKS > 1
+    xcl::parallel_for(globalbuffersize, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            input_host[i] = i % 256;
+        }
+    });
+
+    /* The kernel is built with one port per DDR bank of the platform. Every
+     * argument but the last, num_blocks, is a buffer: the inputs are read
+     * and copied by the kernel into the outputs. The bank of each port is
+     * taken from the memory topology of the xclbin, so the same host runs
+     * any bank count. */
+    auto banks = get_arg_banks(*fileBuf, "bandwidth");
+    cl_uint num_args;
+    OCL_CHECK(err, num_args = krnl_global_bandwidth.getInfo<CL_KERNEL_NUM_ARGS>(&err));
+    std::vector<port_t> ports(num_args - 1);
+    for (cl_uint i = 0; i < ports.size(); i++) {
+        port_t& port = ports[i];
+        port.arg = i;
+        OCL_CHECK(err, port.name = krnl_global_bandwidth.getArgInfo<CL_KERNEL_ARG_NAME>(i, &err));
+        port.input = port.name.compare(0, 5, "input") == 0;
+        if (banks.count(i) == 0) {
+            printf("Error: No memory bank found in the xclbin for argument %s\n", port.name.c_str());
+            return EXIT_FAILURE;
+        }
+        port.bank = banks[i].first;
+        port.tag = banks[i].second;
+        printf("%s %s -> %s\n", port.input ? "Read " : "Write", port.name.c_str(), port.tag.c_str());
 
-    for (int i = 0; i < ddr_banks; i++) {
-        buffer[i] = new cl::Buffer(context, CL_MEM_READ_WRITE, globalbuffersize, nullptr, &err);
+        port.buffer = cl::Buffer(context, CL_MEM_READ_WRITE, globalbuffersize, nullptr, &err);
         if (err != CL_SUCCESS) {
-            printf("Error: Failed to allocate buffer in DDR bank %zu\n", globalbuffersize);
+            printf("Error: Failed to allocate buffer in DDR bank %s\n", port.tag.c_str());
             return EXIT_FAILURE;
         }
-    } /* End for (i < ddr_banks) */
-#else
-    OCL_CHECK(err, buffer[0] = new cl::Buffer(context, CL_MEM_READ_WRITE, globalbuffersize, nullptr, &err));
-    OCL_CHECK(err, buffer[1] = new cl::Buffer(context, CL_MEM_READ_WRITE, globalbuffersize, nullptr, &err));
-#endif
+    }
 
     /*
      * Using setArg(), i.e. setting kernel arguments, explicitly before copying
@@ -157,19 +217,12 @@ int main(int argc, char** argv) {
     */
 
     /* Set the kernel arguments */
-    int arg_index = 0;
-    int buffer_index = 0;
     cl_ulong num_blocks = globalbuffersize / 64;
 
-    OCL_CHECK(err, err = krnl_global_bandwidth.setArg(arg_index++, *(buffer[buffer_index++])));
-    OCL_CHECK(err, err = krnl_global_bandwidth.setArg(arg_index++, *(buffer[buffer_index++])));
-#if NDDR_BANKS == 3
-    OCL_CHECK(err, err = krnl_global_bandwidth.setArg(arg_index++, *(buffer[buffer_index++])));
-#elif NDDR_BANKS > 3
-    OCL_CHECK(err, err = krnl_global_bandwidth.setArg(arg_index++, *(buffer[buffer_index++])));
-    OCL_CHECK(err, err = krnl_global_bandwidth.setArg(arg_index++, *(buffer[buffer_index++])));
-#endif
-    OCL_CHECK(err, err = krnl_global_bandwidth.setArg(arg_index++, num_blocks));
+    for (auto& port : ports) {
+        OCL_CHECK(err, err = krnl_global_bandwidth.setArg(port.arg, port.buffer));
+    }
+    OCL_CHECK(err, err = krnl_global_bandwidth.setArg(num_args - 1, num_blocks));
 
     double dbytes = globalbuffersize;
     double dmbytes = dbytes / (((double)1024) * ((double)1024));
@@ -178,116 +231,120 @@ int main(int argc, char** argv) {
         "memory... \n",
         dmbytes);
 
-    /* Write input buffer */
-    /* Map input buffer for PCIe write */
-    unsigned char* map_input_buffer0;
-    OCL_CHECK(err,
-              map_input_buffer0 = (unsigned char*)q.enqueueMapBuffer(
-                  *(buffer[0]), CL_FALSE, CL_MAP_WRITE_INVALIDATE_REGION, 0, globalbuffersize, nullptr, nullptr, &err));
+    /* Write input buffers */
+    /* Map all input buffers for PCIe write at once and fill them together */
+    for (auto& port : ports) {
+        if (!port.input) continue;
+        OCL_CHECK(err, port.map = (unsigned char*)q.enqueueMapBuffer(port.buffer, CL_FALSE,
+                                                                     CL_MAP_WRITE_INVALIDATE_REGION, 0,
+                                                                     globalbuffersize, nullptr, nullptr, &err));
+    }
     OCL_CHECK(err, err = q.finish());
 
     /* prepare data to be written to the device */
-    for (size_t i = 0; i < globalbuffersize; i++) {
-        map_input_buffer0[i] = input_host[i];
+    xcl::parallel_for(globalbuffersize, [&](size_t begin, size_t end) {
+        for (auto& port : ports) {
+            if (port.input) memcpy(port.map + begin, input_host + begin, end - begin);
+        }
+    });
+    for (auto& port : ports) {
+        if (port.input) {
+            OCL_CHECK(err, err = q.enqueueUnmapMemObject(port.buffer, port.map));
+        }
     }
-    OCL_CHECK(err, err = q.enqueueUnmapMemObject(*(buffer[0]), map_input_buffer0));
-
-    OCL_CHECK(err, err = q.finish());
-
-#if NDDR_BANKS > 3
-    unsigned char* map_input_buffer1;
-    OCL_CHECK(err,
-              map_input_buffer1 = (unsigned char*)q.enqueueMapBuffer(
-                  *(buffer[2]), CL_FALSE, CL_MAP_WRITE_INVALIDATE_REGION, 0, globalbuffersize, nullptr, nullptr, &err));
     OCL_CHECK(err, err = q.finish());
 
-    /* Prepare data to be written to the device */
-    for (size_t i = 0; i < globalbuffersize; i++) {
-        map_input_buffer1[i] = input_host[i];
+    /* Execute Kernel, repeated until the mean of its profiled run time is
+     * stable. The time from queueing the task to its start is the launch
+     * latency of the kernel. */
+    xcl::Benchmark bench;
+    bench.describe();
+    std::vector<double> launch_us;
+    auto stats = bench.measure([&] {
+        cl::Event event;
+        OCL_CHECK(err, err = q.enqueueTask(krnl_global_bandwidth, nullptr, &event));
+        OCL_CHECK(err, err = event.wait());
+        unsigned long end = OCL_CHECK(err, event.getProfilingInfo<CL_PROFILING_COMMAND_END>(&err));
+        unsigned long start = OCL_CHECK(err, event.getProfilingInfo<CL_PROFILING_COMMAND_START>(&err));
+        unsigned long queued = OCL_CHECK(err, event.getProfilingInfo<CL_PROFILING_COMMAND_QUEUED>(&err));
+        launch_us.push_back((start - queued) / 1000.0);
+        return (end - start) / 1e9;
+    });
+    unsigned long nsduration = stats.mean * 1e9;
+
+    /* Copy results back from OpenCL buffers */
+    for (auto& port : ports) {
+        if (port.input) continue;
+        OCL_CHECK(err, port.map = (unsigned char*)q.enqueueMapBuffer(port.buffer, CL_FALSE, CL_MAP_READ, 0,
+                                                                     globalbuffersize, nullptr, nullptr, &err));
     }
-
-    OCL_CHECK(err, err = q.enqueueUnmapMemObject(*(buffer[2]), map_input_buffer1));
-    OCL_CHECK(err, err = q.finish());
-#endif
-
-    unsigned long start, end, nsduration;
-    cl::Event event;
-
-    /* Execute Kernel */
-    OCL_CHECK(err, err = q.enqueueTask(krnl_global_bandwidth, nullptr, &event));
-    OCL_CHECK(err, err = event.wait());
-    end = OCL_CHECK(err, event.getProfilingInfo<CL_PROFILING_COMMAND_END>(&err));
-    start = OCL_CHECK(err, event.getProfilingInfo<CL_PROFILING_COMMAND_START>(&err));
-    nsduration = end - start;
-
-    /* Copy results back from OpenCL buffer */
-    unsigned char* map_output_buffer0;
-    OCL_CHECK(err, map_output_buffer0 = (unsigned char*)q.enqueueMapBuffer(*(buffer[1]), CL_FALSE, CL_MAP_READ, 0,
-                                                                           globalbuffersize, nullptr, nullptr, &err));
     OCL_CHECK(err, err = q.finish());
 
-    std::cout << "Kernel Duration..." << nsduration << " ns" << std::endl;
+    std::cout << "Kernel Duration..." << nsduration << " ns, mean of " << stats.samples.size() << " runs"
+              << std::endl;
 
-    /* Check the results of output0 */
-    for (size_t i = 0; i < globalbuffersize; i++) {
-        if (map_output_buffer0[i] != input_host[i]) {
-            printf("ERROR : kernel failed to copy entry %zu input %i output %i\n", i, input_host[i],
-                   map_output_buffer0[i]);
+    /* Check the results of every output */
+    for (auto& port : ports) {
+        if (port.input) continue;
+        size_t i = xcl::first_mismatch(input_host, port.map, globalbuffersize);
+        if (i != globalbuffersize) {
+            printf("ERROR : kernel failed to copy entry %zu of %s input %i output %i\n", i, port.name.c_str(),
+                   input_host[i], port.map[i]);
             return EXIT_FAILURE;
         }
+        OCL_CHECK(err, err = q.enqueueUnmapMemObject(port.buffer, port.map));
     }
-#if NDDR_BANKS == 3
-    unsigned char* map_output_buffer1;
-    OCL_CHECK(err, map_output_buffer1 = (unsigned char*)q.enqueueMapBuffer(*(buffer[2]), CL_FALSE, CL_MAP_READ, 0,
-                                                                           globalbuffersize, nullptr, nullptr, &err));
-    OCL_CHECK(err, err = q.finish());
-
-    /* Check the results of output1 */
-    for (size_t i = 0; i < globalbuffersize; i++) {
-        if (map_output_buffer1[i] != input_host[i]) {
-            printf("ERROR : kernel failed to copy entry %zu input %i output %i\n", i, input_host[i],
-                   map_output_buffer1[i]);
-            return EXIT_FAILURE;
-        }
-    }
-#endif
-
-#if NDDR_BANKS > 3
-    unsigned char* map_output_buffer1;
-    OCL_CHECK(err, map_output_buffer1 = (unsigned char*)q.enqueueMapBuffer(*(buffer[3]), CL_FALSE, CL_MAP_READ, 0,
-                                                                           globalbuffersize, nullptr, nullptr, &err));
     OCL_CHECK(err, err = q.finish());
 
-    /* Check the results of output1 */
-    for (size_t i = 0; i < globalbuffersize; i++) {
-        if (map_output_buffer1[i] != input_host[i]) {
-            printf("ERROR : kernel failed to copy entry %zu input %i output %i\n", i, input_host[i],
-                   map_output_buffer1[i]);
-            return EXIT_FAILURE;
-        }
-    }
-#endif
-
-#if NDDR_BANKS > 1
-    for (int i = 0; i < ddr_banks; i++) {
-        delete (buffer[i]);
-    }
-#else
-    delete (buffer[0]);
-    delete (buffer[1]);
-#endif
-
     /* Profiling information */
     double dnsduration = ((double)nsduration);
     double dsduration = dnsduration / ((double)1000000000);
 
     double bpersec = (dbytes / dsduration);
-    double gbpersec = bpersec / ((double)1024 * 1024 * 1024) * num_buffers;
+    double gbpersec_port = bpersec / ((double)1024 * 1024 * 1024);
 
     printf("Kernel completed read/write %.0lf MB bytes from/to global memory.\n", dmbytes);
     printf("Execution time = %f (sec) \n", dsduration);
-    printf("Concurrent Read and Write Throughput = %f (GB/sec) \n", gbpersec);
 
+    /* Every port moves the whole buffer during the kernel run. Only the
+     * kernel run is timed, so the bank figures and totals below are the
+     * bytes of their ports over that one duration, not measured per bank */
+    std::map<int, std::pair<int, int> > bank_ports; // bank -> read, write ports
+    std::map<int, std::string> bank_tags;
+    int num_reads = 0;
+    int num_writes = 0;
+    for (auto& port : ports) {
+        (port.input ? bank_ports[port.bank].first : bank_ports[port.bank].second)++;
+        (port.input ? num_reads : num_writes)++;
+        bank_tags[port.bank] = port.tag;
+    }
+    xcl::Results results("kernel_global_bandwidth");
+    printf("Derived from the kernel execution time, not measured per bank:\n");
+    for (auto& bank : bank_ports) {
+        for (auto sample : stats.samples)
+            results.add("Bank Throughput", "GB/s", {{"bank", bank_tags[bank.first]}},
+                        gbpersec_port * stats.mean / sample * (bank.second.first + bank.second.second));
+        printf("%s: Read %f (GB/sec), Write %f (GB/sec), Total %f (GB/sec) \n", bank_tags[bank.first].c_str(),
+               gbpersec_port * bank.second.first, gbpersec_port * bank.second.second,
+               gbpersec_port * (bank.second.first + bank.second.second));
+    }
+    printf("Read Throughput = %f (GB/sec) \n", gbpersec_port * num_reads);
+    printf("Write Throughput = %f (GB/sec) \n", gbpersec_port * num_writes);
+    printf("Concurrent Read and Write Throughput = %f (GB/sec) \n", gbpersec_port * ports.size());
+    printf("Launch Latency = %f (us) \n", launch_us.back());
+    for (auto sample : stats.samples) {
+        double gbpersec_sample = gbpersec_port * stats.mean / sample;
+        results.add("Read Throughput", "GB/s", {}, gbpersec_sample * num_reads);
+        results.add("Write Throughput", "GB/s", {}, gbpersec_sample * num_writes);
+        results.add("Concurrent Read and Write Throughput", "GB/s", {}, gbpersec_sample * ports.size());
+    }
+    // The warmup runs are not kept
+    for (size_t i = bench.warmup; i < launch_us.size(); i++) {
+        results.add("Launch Latency", "us", {}, launch_us[i], xcl::Results::LOWER);
+    }
+    results.write();
+
+    free(input_host);
     printf("TEST PASSED\n");
     return EXIT_SUCCESS;
 }
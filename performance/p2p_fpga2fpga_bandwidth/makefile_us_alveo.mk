@@ -52,7 +52,7 @@ LINK_OUTPUT := $(BUILD_DIR)/bandwidth.link.xclbin
 PACKAGE_OUT = ./package.$(TARGET)
 
 VPP_PFLAGS := 
-CMD_ARGS = -x1 $(BUILD_DIR)/bandwidth.xclbin -x2 $(BUILD_DIR)/bandwidth.xclbin
+CMD_ARGS = -x1 $(BUILD_DIR)/bandwidth.xclbin -x2 $(BUILD_DIR)/bandwidth.xclbin -p 64M
 CXXFLAGS += -I$(XILINX_XRT)/include -I$(XILINX_VIVADO)/include -Wall -O0 -g -std=c++1y
 LDFLAGS += -L$(XILINX_XRT)/lib -pthread -lOpenCL
 
@@ -63,6 +63,8 @@ PLATFORM_BLOCKLIST += zc 201910 2018 vck aws-vu9p-f1 u25_ u30 u50_gen3x16_xdma_2
 CXXFLAGS += -I$(XF_PROJ_ROOT)/common/includes/xcl2
 CXXFLAGS += -I$(XF_PROJ_ROOT)/common/includes/cmdparser
 CXXFLAGS += -I$(XF_PROJ_ROOT)/common/includes/logger
+CXXFLAGS += -I$(XF_PROJ_ROOT)/common/includes/results
+CXXFLAGS += -I$(XF_PROJ_ROOT)/common/includes/benchmark
 HOST_SRCS += $(XF_PROJ_ROOT)/common/includes/xcl2/xcl2.cpp $(XF_PROJ_ROOT)/common/includes/cmdparser/cmdlineparser.cpp $(XF_PROJ_ROOT)/common/includes/logger/logger.cpp src/host.cpp 
 # Host compiler global settings
 CXXFLAGS += -fmessage-length=0
@@ -15,15 +15,22 @@
 */
 
 extern "C" {
-void bandwidth(unsigned int* buffer0, unsigned int* buffer1) {
+void bandwidth(unsigned int* buffer0, unsigned int* buffer1, unsigned int count, unsigned int offset) {
 #pragma HLS INTERFACE m_axi port = buffer0 offset = slave bundle = gmem0
 #pragma HLS INTERFACE m_axi port = buffer1 offset = slave bundle = gmem1
 
 #pragma HLS INTERFACE s_axilite port = buffer0
 #pragma HLS INTERFACE s_axilite port = buffer1
+#pragma HLS INTERFACE s_axilite port = count
+#pragma HLS INTERFACE s_axilite port = offset
 #pragma HLS INTERFACE s_axilite port = return
 
-    // Intentional empty kernel as this example doesn't require actual
-    // kernel to work.
+    // The bandwidth sweep only copies buffers and runs no kernel. The
+    // pipelined mode processes every received chunk by adding one to its
+    // count words and writing them to buffer1 from word offset.
+    for (unsigned int i = 0; i < count; i++) {
+#pragma HLS PIPELINE II = 1
+        buffer1[offset + i] = buffer0[i] + 1;
+    }
 }
 }
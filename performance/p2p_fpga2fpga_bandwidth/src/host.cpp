@@ -13,8 +13,11 @@
 * License for the specific language governing permissions and limitations
 * under the License.
 */
+#include "benchmark.hpp"
 #include "cmdlineparser.h"
+#include "results.hpp"
 #include "xcl2.hpp"
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <stdio.h>
@@ -29,6 +32,126 @@ decltype(&xclGetMemObjectFromFd) xcl::P2P::getMemObjectFromFd = nullptr;
 
 cl_program xcl_import_binary_file(cl_device_id device_id, cl_context context, const char* xclbin_file_name);
 
+// Pipelined mode: the first bytes of src on device 0 go to device 1 in
+// chunks, through two ping-pong P2P buffers of device 1. Device 0 copies
+// chunk k into one of them while the kernel of device 1 processes chunk k-1
+// from the other into out. The two queues belong to different contexts, so
+// the host orders them: chunk k is copied once the kernel of chunk k-2 left
+// its buffer, and chunk k-1 is processed once its copy is done. The copies
+// alone and the kernels alone are timed as well, to compare the pipeline
+// against its stages. Returns false if out does not hold src plus one.
+static bool pipelined_transfer(cl_context context[2],
+                               cl_device_id device[2],
+                               cl_command_queue queue[2],
+                               cl_kernel krnl,
+                               cl_mem src,
+                               cl_mem out,
+                               const std::vector<data_t, aligned_allocator<data_t> >& in_host,
+                               const std::vector<data_t, aligned_allocator<data_t> >& out_host,
+                               uint64_t bytes,
+                               int chunks,
+                               xcl::Benchmark& bench,
+                               xcl::Results& results) {
+    cl_int err;
+    size_t words = bytes / sizeof(data_t);
+    size_t chunk_words = (words + chunks - 1) / chunks;
+    size_t chunk_bytes = chunk_words * sizeof(data_t);
+    chunks = (words + chunk_words - 1) / chunk_words;
+
+    cl_mem ping[2], ping_imported[2];
+    for (int b = 0; b < 2; b++) {
+        cl_mem_ext_ptr_t ping_ext = {XCL_MEM_EXT_P2P_BUFFER, nullptr, 0};
+        OCL_CHECK(err, ping[b] = clCreateBuffer(context[1], CL_MEM_READ_WRITE | CL_MEM_EXT_PTR_XILINX, chunk_bytes,
+                                                &ping_ext, &err));
+        int fd = -1;
+        OCL_CHECK(err, err = xcl::P2P::getMemObjectFd(ping[b], &fd));
+        OCL_CHECK(err, err = xcl::P2P::getMemObjectFromFd(context[0], device[0], 0, fd, &ping_imported[b]));
+    }
+    // The sweep overwrote the device copy of src
+    OCL_CHECK(err, err = clEnqueueMigrateMemObjects(queue[0], 1, &src, 0, 0, nullptr, nullptr));
+    OCL_CHECK(err, err = clFinish(queue[0]));
+
+    auto copy = [&](int k, cl_event* done) {
+        size_t n = std::min(chunk_words, words - k * chunk_words);
+        cl_mem dst = ping_imported[k % 2];
+        OCL_CHECK(err, err = clEnqueueCopyBuffer(queue[0], src, dst, k * chunk_bytes, 0, n * sizeof(data_t), 0,
+                                                 nullptr, done));
+    };
+    auto process = [&](int k, cl_event* done) {
+        cl_uint n = std::min(chunk_words, words - k * chunk_words);
+        cl_uint offset = k * chunk_words;
+        cl_mem in = ping[k % 2];
+        OCL_CHECK(err, err = clSetKernelArg(krnl, 0, sizeof(cl_mem), &in));
+        OCL_CHECK(err, err = clSetKernelArg(krnl, 1, sizeof(cl_mem), &out));
+        OCL_CHECK(err, err = clSetKernelArg(krnl, 2, sizeof(cl_uint), &n));
+        OCL_CHECK(err, err = clSetKernelArg(krnl, 3, sizeof(cl_uint), &offset));
+        OCL_CHECK(err, err = clEnqueueTask(queue[1], krnl, 0, nullptr, done));
+    };
+    auto wait = [&](cl_event& event) {
+        if (event == nullptr) return;
+        OCL_CHECK(err, err = clWaitForEvents(1, &event));
+        clReleaseEvent(event);
+        event = nullptr;
+    };
+
+    auto copy_stats = bench.run([&] {
+        for (int k = 0; k < chunks; k++) copy(k, nullptr);
+        clFinish(queue[0]);
+    });
+    auto krnl_stats = bench.run([&] {
+        for (int k = 0; k < chunks; k++) process(k, nullptr);
+        clFinish(queue[1]);
+    });
+    auto pipe_stats = bench.run([&] {
+        cl_event copied[2] = {nullptr, nullptr};
+        cl_event processed[2] = {nullptr, nullptr};
+        for (int k = 0; k <= chunks; k++) {
+            if (k < chunks) {
+                wait(processed[k % 2]);
+                copy(k, &copied[k % 2]);
+                clFlush(queue[0]);
+            }
+            if (k > 0) {
+                wait(copied[(k - 1) % 2]);
+                process(k - 1, &processed[(k - 1) % 2]);
+                clFlush(queue[1]);
+            }
+        }
+        wait(processed[0]);
+        wait(processed[1]);
+    });
+
+    double gb = words * sizeof(data_t) / ((double)1024 * 1024 * 1024);
+    double copy_gbps = gb / copy_stats.mean;
+    double krnl_gbps = gb / krnl_stats.mean;
+    double pipe_gbps = gb / pipe_stats.mean;
+    std::cout << "Pipeline = " << xcl::convert_size(words * sizeof(data_t)) << " in " << chunks << " chunks of "
+              << xcl::convert_size(chunk_bytes) << "\nCopy only = " << std::setprecision(2) << std::fixed
+              << copy_gbps << "GB/s Kernel only = " << krnl_gbps << "GB/s Pipelined = " << pipe_gbps << "GB/s, "
+              << 100 * pipe_gbps / copy_gbps << "% of the copy bandwidth\n";
+    xcl::Results::Params params = {{"size", words * sizeof(data_t)}, {"chunks", chunks}};
+    for (auto sample : copy_stats.samples) results.add("Pipeline Copy", "GB/s", params, gb / sample);
+    for (auto sample : krnl_stats.samples) results.add("Pipeline Kernel", "GB/s", params, gb / sample);
+    for (auto sample : pipe_stats.samples) results.add("Pipeline Throughput", "GB/s", params, gb / sample);
+
+    for (int b = 0; b < 2; b++) {
+        clReleaseMemObject(ping_imported[b]);
+        clReleaseMemObject(ping[b]);
+    }
+
+    OCL_CHECK(err, err = clEnqueueMigrateMemObjects(queue[1], 1, &out, CL_MIGRATE_MEM_OBJECT_HOST, 0, nullptr,
+                                                    nullptr));
+    OCL_CHECK(err, err = clFinish(queue[1]));
+    for (size_t i = 0; i < words; i++) {
+        if (out_host[i] != in_host[i] + 1) {
+            std::cout << "ERROR: pipelined word " << i << " is " << out_host[i] << ", expected " << in_host[i] + 1
+                      << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
 int main(int argc, char* argv[]) {
     // Command Line Parser
     sda::utils::CmdLineParser parser;
@@ -39,6 +162,9 @@ int main(int argc, char* argv[]) {
     parser.addSwitch("--xclbin_file2", "-x2", "input binary file2 string", "");
     parser.addSwitch("--device0", "-d0", "first device id", "0");
     parser.addSwitch("--device1", "-d1", "second device id", "1");
+    parser.addSwitch("--sizes", "-s", "buffer sizes, a list or range such as 4K..64M:x2", "4K..64M:x2");
+    parser.addSwitch("--pipeline", "-p", "size of the pipelined transfer such as 256M, 0 to skip it", "0");
+    parser.addSwitch("--chunks", "-c", "number of chunks of the pipelined transfer", "16");
     parser.parse(argc, argv);
 
     // Read settings
@@ -50,23 +176,35 @@ int main(int argc, char* argv[]) {
 
     if (argc < 5) {
         std::cout << "Options: <exe> <-x1> <first xclbin> <-x2> <second xclbin> "
-                     "<optional> <-d0> <device id0> <-d1> <device id1>"
+                     "<optional> <-d0> <device id0> <-d1> <device id1> <-s> <buffer sizes> <-p> <pipeline size> "
+                     "<-c> <chunks>"
                   << std::endl;
         return EXIT_FAILURE;
     }
 
-    int max_buffer = 16 * 1024 * 1024;
-    size_t min_buffer = 4 * 1024;
+    std::vector<uint64_t> sizes = parser.value_to_list("sizes");
     if (xcl::is_emulation()) {
-        max_buffer = 4 * 1024;
+        std::vector<uint64_t> emu_sizes;
+        for (auto size : sizes) {
+            if (size <= 4 * 1024 * sizeof(data_t)) emu_sizes.push_back(size);
+        }
+        sizes = emu_sizes;
     }
-
-    std::vector<data_t, aligned_allocator<data_t> > in1(max_buffer);
-    std::vector<data_t, aligned_allocator<data_t> > out1(max_buffer);
-    for (int i = 0; i < max_buffer; i++) {
-        in1[i] = i;
-        out1[i] = 0;
+    if (sizes.empty()) {
+        std::cout << "ERROR: no valid buffer size given with -s" << std::endl;
+        return EXIT_FAILURE;
     }
+    uint64_t pipeline_bytes = parser.value_to_size("pipeline");
+    int chunks = parser.value_to_int("chunks");
+    if (xcl::is_emulation()) {
+        pipeline_bytes = std::min<uint64_t>(pipeline_bytes, 4 * 1024 * sizeof(data_t));
+    }
+    if (pipeline_bytes && (chunks < 1 || pipeline_bytes / sizeof(data_t) < (uint64_t)chunks)) {
+        std::cout << "ERROR: the pipelined transfer needs at least one word in each of 1 or more chunks" << std::endl;
+        return EXIT_FAILURE;
+    }
+    // The buffers hold the largest size, smaller sizes copy a prefix of them
+    uint64_t max_bytes = std::max(*std::max_element(sizes.begin(), sizes.end()), pipeline_bytes);
 
     cl_platform_id platform_id;
     cl_platform_id platforms[16] = {0};
@@ -131,6 +269,27 @@ int main(int argc, char* argv[]) {
         return 0;
     }
 
+    // Every buffer of a device holds max_bytes, which must fit in a single
+    // allocation of both devices
+    for (int i = 0; i < 2; i++) {
+        cl_ulong max_alloc = 0;
+        clGetDeviceInfo(device[i], CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(max_alloc), &max_alloc, nullptr);
+        if (max_alloc && max_bytes > max_alloc) {
+            std::cout << "ERROR: buffers of " << xcl::convert_size(max_bytes) << " exceed the largest allocation of "
+                      << xcl::convert_size(max_alloc) << " on device[" << i << "], use smaller -s or -p sizes"
+                      << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    size_t max_buffer = (max_bytes + sizeof(data_t) - 1) / sizeof(data_t);
+
+    std::vector<data_t, aligned_allocator<data_t> > in1(max_buffer);
+    std::vector<data_t, aligned_allocator<data_t> > out1(max_buffer);
+    for (size_t i = 0; i < max_buffer; i++) {
+        in1[i] = i;
+        out1[i] = 0;
+    }
+
     cl_context context[2];
     cl_command_queue queue[2];
     cl_kernel krnl_dev0, krnl_dev1;
@@ -181,13 +340,23 @@ int main(int argc, char* argv[]) {
     OCL_CHECK(err, rbo2 = clCreateBuffer(context[1], CL_MEM_USE_HOST_PTR | CL_MEM_READ_WRITE, vector_size_bytes,
                                          in1.data(), &err));
 
+    // Output of the kernel of Device2 in the pipelined mode
+    cl_mem obo2;
+    OCL_CHECK(err, obo2 = clCreateBuffer(context[1], CL_MEM_USE_HOST_PTR | CL_MEM_READ_WRITE, vector_size_bytes,
+                                         out1.data(), &err));
+
     // ----------------------------Set Args
     // -------------------------------------------
+    cl_uint no_words = 0;
     OCL_CHECK(err, err = clSetKernelArg(krnl_dev0, 0, sizeof(cl_mem), &pbo1));
     OCL_CHECK(err, err = clSetKernelArg(krnl_dev0, 1, sizeof(cl_mem), &rbo1));
+    OCL_CHECK(err, err = clSetKernelArg(krnl_dev0, 2, sizeof(cl_uint), &no_words));
+    OCL_CHECK(err, err = clSetKernelArg(krnl_dev0, 3, sizeof(cl_uint), &no_words));
 
     OCL_CHECK(err, err = clSetKernelArg(krnl_dev1, 0, sizeof(cl_mem), &pbo2));
     OCL_CHECK(err, err = clSetKernelArg(krnl_dev1, 1, sizeof(cl_mem), &rbo2));
+    OCL_CHECK(err, err = clSetKernelArg(krnl_dev1, 2, sizeof(cl_uint), &no_words));
+    OCL_CHECK(err, err = clSetKernelArg(krnl_dev1, 3, sizeof(cl_uint), &no_words));
 
     // -----------------------------------------------------------------------
     std::cout << "Write input data to device global memory" << std::endl;
@@ -214,118 +383,81 @@ int main(int argc, char* argv[]) {
 
     size_t max_size = 128 * 1024 * 1024; // 128MB size
     std::cout << "Start P2P copy of various Buffer sizes \n";
-    for (size_t bufsize = min_buffer; bufsize <= vector_size_bytes; bufsize *= 2) {
+    xcl::Results results("p2p_fpga2fpga_bandwidth");
+    xcl::Benchmark bench;
+    bench.describe();
+
+    // Bandwidth in GB/s of iter copies of bufsize bytes from src to dst on
+    // queue, each followed by the copy back when both is set. The batch of
+    // copies is repeated by the benchmark harness, every kept batch is a
+    // sample of the result and the mean batch time gives the bandwidth.
+    auto copy_bandwidth = [&](cl_command_queue queue, cl_mem src, cl_mem dst, bool both, size_t bufsize, int iter,
+                              const std::string& name, int dev) {
+        auto stats = bench.run([&] {
+            for (int j = 0; j < iter; j++) {
+                OCL_CHECK(err, err = clEnqueueCopyBuffer(queue, src, dst, 0, 0, bufsize, 0, nullptr, nullptr));
+                if (both) {
+                    OCL_CHECK(err, err = clEnqueueCopyBuffer(queue, dst, src, 0, 0, bufsize, 0, nullptr, nullptr));
+                }
+            }
+            clFinish(queue);
+        });
+        double bytes = (both ? 2.0 : 1.0) * iter * bufsize;
+        for (auto sample : stats.samples) {
+            results.add(name, "GB/s", {{"device", dev}, {"buffer_size", bufsize}},
+                        bytes / sample / ((double)1024 * 1024 * 1024));
+        }
+        return bytes / stats.mean / ((double)1024 * 1024 * 1024);
+    };
+
+    for (size_t bufsize : sizes) {
         std::string size_str = xcl::convert_size(bufsize);
-        int iter = max_size / bufsize;
+        int iter = std::max<size_t>(max_size / bufsize, 1);
         if (xcl::is_emulation()) {
             iter = 2; // Reducing iteration to run faster in emulation flow.
         }
-        double dnsduration, dsduration, gbpersec;
-        std::chrono::high_resolution_clock::time_point p2pReadWriteStart, p2pReadWriteEnd;
-        cl_ulong p2pReadWriteTime;
+        double gbpersec;
         if (!dev0_nodma_chk) {
             //////////////////////// DMA Write by FPGA-1 //////////////////////////
-            std::chrono::high_resolution_clock::time_point p2pReadStart = std::chrono::high_resolution_clock::now();
-            for (int j = 0; j < iter; j++) {
-                OCL_CHECK(err, err = clEnqueueCopyBuffer(queue[0], rbo1, pbo2_imported, 0, 0, bufsize, 0, nullptr,
-                                                         nullptr)); // FPGA1 DMA Write
-            }
-            clFinish(queue[0]);
-            std::chrono::high_resolution_clock::time_point p2pReadEnd = std::chrono::high_resolution_clock::now();
-            cl_ulong p2pReadTime =
-                std::chrono::duration_cast<std::chrono::microseconds>(p2pReadEnd - p2pReadStart).count();
-            ;
-            dnsduration = (double)p2pReadTime;
-            dsduration = dnsduration / ((double)1000000);
-            gbpersec = ((iter * bufsize) / dsduration) / ((double)1024 * 1024 * 1024);
+            gbpersec = copy_bandwidth(queue[0], rbo1, pbo2_imported, false, bufsize, iter, "DMA Write", 0);
             std::cout << "Buffer = " << size_str << " Iterations = " << iter
                       << " Total Data Transfer = " << xcl::convert_size(max_size)
                       << "\nDevice0 : DMA Write = " << std::setprecision(2) << std::fixed << gbpersec << "GB/s";
 
             //////////////////////// DMA Read by FPGA-1 //////////////////////////
-            p2pReadStart = std::chrono::high_resolution_clock::now();
-            for (int j = 0; j < iter; j++) {
-                OCL_CHECK(err, err = clEnqueueCopyBuffer(queue[0], pbo2_imported, rbo1, 0, 0, bufsize, 0, nullptr,
-                                                         nullptr)); // FPGA1 DMA Read
-            }
-            clFinish(queue[0]);
-            p2pReadEnd = std::chrono::high_resolution_clock::now();
-            p2pReadTime = std::chrono::duration_cast<std::chrono::microseconds>(p2pReadEnd - p2pReadStart).count();
-            ;
-            dnsduration = (double)p2pReadTime;
-            dsduration = dnsduration / ((double)1000000);
-            gbpersec = ((iter * bufsize) / dsduration) / ((double)1024 * 1024 * 1024);
+            gbpersec = copy_bandwidth(queue[0], pbo2_imported, rbo1, false, bufsize, iter, "DMA Read", 0);
             std::cout << " DMA Read = " << std::setprecision(2) << std::fixed << gbpersec << "GB/s";
 
             //////////////////////// FPGA1 Read Write throughput /////////////////
-            p2pReadWriteStart = std::chrono::high_resolution_clock::now();
-            for (int j = 0; j < iter; j++) {
-                OCL_CHECK(err, err = clEnqueueCopyBuffer(queue[0], rbo1, pbo2_imported, 0, 0, bufsize, 0, nullptr,
-                                                         nullptr)); // FPGA1 DMA Write
-                OCL_CHECK(err, err = clEnqueueCopyBuffer(queue[0], pbo2_imported, rbo1, 0, 0, bufsize, 0, nullptr,
-                                                         nullptr)); // FPGA1 DMA Read
-            }
-            clFinish(queue[0]);
-
-            p2pReadWriteEnd = std::chrono::high_resolution_clock::now();
-            p2pReadWriteTime =
-                std::chrono::duration_cast<std::chrono::microseconds>(p2pReadWriteEnd - p2pReadWriteStart).count();
-            ;
-            dnsduration = (double)p2pReadWriteTime;
-            dsduration = dnsduration / ((double)1000000);
-            gbpersec = ((2 * iter * bufsize) / dsduration) / ((double)1024 * 1024 * 1024);
+            gbpersec = copy_bandwidth(queue[0], rbo1, pbo2_imported, true, bufsize, iter, "DMA Read Write", 0);
             std::cout << " DMA Read Write = " << std::setprecision(2) << std::fixed << gbpersec << "GB/s\n";
         }
         if (!dev1_nodma_chk) {
             //////////////////////// DMA Write by FPGA-2 //////////////////////////
-            std::chrono::high_resolution_clock::time_point p2pWriteStart = std::chrono::high_resolution_clock::now();
-            for (int j = 0; j < iter; j++) {
-                OCL_CHECK(err, err = clEnqueueCopyBuffer(queue[1], rbo2, pbo1_imported, 0, 0, bufsize, 0, nullptr,
-                                                         nullptr)); // FPGA2 DMA Write
-            }
-            clFinish(queue[1]);
-            std::chrono::high_resolution_clock::time_point p2pWriteEnd = std::chrono::high_resolution_clock::now();
-            cl_ulong p2pWriteTime =
-                std::chrono::duration_cast<std::chrono::microseconds>(p2pWriteEnd - p2pWriteStart).count();
-            dnsduration = (double)p2pWriteTime;
-            dsduration = dnsduration / ((double)1000000);
-            gbpersec = ((iter * bufsize) / dsduration) / ((double)1024 * 1024 * 1024);
+            gbpersec = copy_bandwidth(queue[1], rbo2, pbo1_imported, false, bufsize, iter, "DMA Write", 1);
             std::cout << "Device1 : DMA Write = " << std::setprecision(2) << std::fixed << gbpersec << "GB/s";
 
             //////////////////////// DMA Read by FPGA-2 //////////////////////////
-            p2pWriteStart = std::chrono::high_resolution_clock::now();
-            for (int j = 0; j < iter; j++) {
-                OCL_CHECK(err, err = clEnqueueCopyBuffer(queue[1], pbo1_imported, rbo2, 0, 0, bufsize, 0, nullptr,
-                                                         nullptr)); // FPGA2 DMA Read
-            }
-            clFinish(queue[1]);
-            p2pWriteEnd = std::chrono::high_resolution_clock::now();
-            p2pWriteTime = std::chrono::duration_cast<std::chrono::microseconds>(p2pWriteEnd - p2pWriteStart).count();
-            dnsduration = (double)p2pWriteTime;
-            dsduration = dnsduration / ((double)1000000);
-            gbpersec = ((iter * bufsize) / dsduration) / ((double)1024 * 1024 * 1024);
+            gbpersec = copy_bandwidth(queue[1], pbo1_imported, rbo2, false, bufsize, iter, "DMA Read", 1);
             std::cout << " DMA Read = " << std::setprecision(2) << std::fixed << gbpersec << "GB/s";
 
             //////////////////////// FPGA2 Read Write throughput /////////////////
-            p2pReadWriteStart = std::chrono::high_resolution_clock::now();
-            for (int j = 0; j < iter; j++) {
-                OCL_CHECK(err, err = clEnqueueCopyBuffer(queue[1], rbo2, pbo1_imported, 0, 0, bufsize, 0, nullptr,
-                                                         nullptr)); // FPGA2 DMA Write
-                OCL_CHECK(err, err = clEnqueueCopyBuffer(queue[1], pbo1_imported, rbo2, 0, 0, bufsize, 0, nullptr,
-                                                         nullptr)); // FPGA2 DMA Read
-            }
-            clFinish(queue[1]);
-            p2pReadWriteEnd = std::chrono::high_resolution_clock::now();
-            p2pReadWriteTime =
-                std::chrono::duration_cast<std::chrono::microseconds>(p2pReadWriteEnd - p2pReadWriteStart).count();
-            ;
-            dnsduration = (double)p2pReadWriteTime;
-            dsduration = dnsduration / ((double)1000000);
-            gbpersec = ((2 * iter * bufsize) / dsduration) / ((double)1024 * 1024 * 1024);
+            gbpersec = copy_bandwidth(queue[1], rbo2, pbo1_imported, true, bufsize, iter, "DMA Read Write", 1);
             std::cout << " DMA Read Write = " << std::setprecision(2) << std::fixed << gbpersec << "GB/s\n\n";
         }
     }
 
+    //////////////////////// Pipelined FPGA-1 to FPGA-2 transfer /////////////////
+    if (pipeline_bytes) {
+        if (dev0_nodma_chk) {
+            std::cout << "WARNING: the pipelined transfer is copied by Device0, which has no DMA, skipped\n";
+        } else if (!pipelined_transfer(context, device, queue, krnl_dev1, rbo1, obo2, in1, out1, pipeline_bytes, chunks,
+                                       bench, results)) {
+            std::cout << "TEST FAILED\n";
+            return EXIT_FAILURE;
+        }
+    }
+
     clFinish(queue[0]);
     clReleaseMemObject(pbo1);
     clReleaseMemObject(rbo1);
@@ -334,6 +466,7 @@ int main(int argc, char* argv[]) {
     clFinish(queue[1]);
     clReleaseMemObject(pbo2);
     clReleaseMemObject(rbo2);
+    clReleaseMemObject(obo2);
     clReleaseMemObject(pbo1_imported);
     clReleaseKernel(krnl_dev0);
     clReleaseKernel(krnl_dev1);
@@ -344,6 +477,7 @@ int main(int argc, char* argv[]) {
         clReleaseCommandQueue(queue[i]);
     }
 
+    results.write();
     std::cout << "Test passed!\n";
     return EXIT_SUCCESS;
 
@@ -67,10 +67,10 @@ int main(int argc, char** argv) {
     // platforms and will return list of devices connected to Xilinx platform
     auto devices = xcl::get_xil_devices();
 
-    // read_binary_file() is a utility API which will load the binaryFile
-    // and will return the pointer to file buffer.
-    auto fileBuf = xcl::read_binary_file(binaryFile);
-    cl::Program::Binaries bins{{fileBuf.data(), fileBuf.size()}};
+    // map_binary_file() is a utility API which will map the binaryFile
+    // and will return a view of the file buffer.
+    auto fileBuf = xcl::map_binary_file(binaryFile);
+    cl::Program::Binaries bins{{fileBuf->data(), fileBuf->size()}};
     bool valid_device = false;
     for (unsigned int i = 0; i < devices.size(); i++) {
         device = devices[i];
@@ -73,11 +73,11 @@ int main(int argc, char** argv) {
     // objects
     // are automatically released once the block ends
     std::string vmulBinaryFile = binaryFile1.c_str();
-    auto fileBuf_vmul = xcl::read_binary_file(vmulBinaryFile);
-    cl::Program::Binaries vmul_bins{{fileBuf_vmul.data(), fileBuf_vmul.size()}};
+    auto fileBuf_vmul = xcl::map_binary_file(vmulBinaryFile);
+    cl::Program::Binaries vmul_bins{{fileBuf_vmul->data(), fileBuf_vmul->size()}};
     auto vaddBinaryFile = binaryFile2.c_str();
-    auto fileBuf_vadd = xcl::read_binary_file(vaddBinaryFile);
-    cl::Program::Binaries vadd_bins{{fileBuf_vadd.data(), fileBuf_vadd.size()}};
+    auto fileBuf_vadd = xcl::map_binary_file(vaddBinaryFile);
+    cl::Program::Binaries vadd_bins{{fileBuf_vadd->data(), fileBuf_vadd->size()}};
     bool valid_device = false;
     for (unsigned int i = 0; i < devices.size(); i++) {
         auto device = devices[i];
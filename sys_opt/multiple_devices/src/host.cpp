@@ -28,7 +28,6 @@ using std::array;
 using std::map;
 using std::vector;
 
-cl::Program load_cl2_binary(cl::Program::Binaries, cl::Device device, cl::Context context);
 // This example demonstrates how to split work among multiple devices.
 int main(int argc, char** argv) {
     if (argc != 3) {
@@ -65,9 +64,7 @@ int main(int argc, char** argv) {
     vector<cl::Buffer> buffer_a(device_count);
     vector<cl::Buffer> buffer_b(device_count);
     vector<cl::Buffer> buffer_result(device_count);
-    vector<cl::Program::Binaries> bins(device_count);
     vector<cl::Platform> platform;
-    std::vector<unsigned char> fileBuf[device_count];
     OCL_CHECK(err, err = cl::Platform::get(&platform));
 
     size_t size_per_device = elements_per_device * sizeof(int);
@@ -77,18 +74,19 @@ int main(int argc, char** argv) {
 
     cl_context_properties props[3] = {CL_CONTEXT_PLATFORM, (cl_context_properties)(platform[0])(), 0};
     std::cout << "Initializing OpenCL objects" << std::endl;
+    // In this example. We will create a context for each of the devices.
+    // program_all() is a utility API which creates the contexts, queues and
+    // programs of all devices concurrently, the first device gets the first
+    // xclbin and the others the second one.
+    vector<std::string> binaries(device_count, binaryFile2);
+    if (device_count > 0) binaries[0] = binaryFile1;
+    auto programmed = xcl::program_all(devices, binaries, CL_QUEUE_PROFILING_ENABLE, props);
     for (int d = 0; d < (int)device_count; d++) {
-        // In this example. We will create a context for each of the devices
-        std::cout << "Creating Context[" << d << "]..." << std::endl;
-        OCL_CHECK(err, contexts[d] = cl::Context(devices[d], props, nullptr, nullptr, &err));
-        OCL_CHECK(err, queues[d] = cl::CommandQueue(contexts[d], devices[d], CL_QUEUE_PROFILING_ENABLE, &err));
+        OCL_CHECK(err, err = programmed[d].err);
+        contexts[d] = programmed[d].context;
+        queues[d] = programmed[d].queue;
+        programs[d] = programmed[d].program;
         OCL_CHECK(err, device_name[d] = devices[d].getInfo<CL_DEVICE_NAME>(&err));
-
-        // read_binary_file() ia a utility API which will load the binaryFile
-        // and will return pointer to file buffer.
-        fileBuf[d] = ((d == 0) ? xcl::read_binary_file(binaryFile1) : xcl::read_binary_file(binaryFile2));
-        bins[d].push_back({fileBuf[d].data(), fileBuf[d].size()});
-        programs[d] = load_cl2_binary(bins[d], devices[d], contexts[d]);
         OCL_CHECK(err, kernels[d] = cl::Kernel(programs[d], "vadd", &err));
 
         // Allocate Buffers in Global Memory
@@ -151,10 +149,3 @@ int main(int argc, char** argv) {
     std::cout << "TEST " << (match ? "PASSED" : "FAILED") << std::endl;
     return (match ? EXIT_SUCCESS : EXIT_FAILURE);
 }
-
-cl::Program load_cl2_binary(cl::Program::Binaries bins, cl::Device device, cl::Context context) {
-    cl_int err;
-    std::vector<cl::Device> devices(1, device);
-    OCL_CHECK(err, cl::Program program(context, devices, bins, nullptr, &err));
-    return program;
-}
@@ -75,8 +75,8 @@ bool run_kernel(std::string& binaryFile, int krnl_id) {
     auto devices = xcl::get_xil_devices();
     printf("\n[PID: %d] Read XCLBIN file\n", pid);
 
-    auto fileBuf = xcl::read_binary_file(binaryFile);
-    cl::Program::Binaries bins{{fileBuf.data(), fileBuf.size()}};
+    auto fileBuf = xcl::map_binary_file(binaryFile);
+    cl::Program::Binaries bins{{fileBuf->data(), fileBuf->size()}};
     bool valid_device = false;
     for (unsigned int i = 0; i < devices.size(); i++) {
         auto device = devices[i];
@@ -165,6 +165,10 @@ int main(int argc, char* argv[]) {
 
     bool result = true;
 
+    // Map the xclbin once in the parent, children inherit the cached mapping
+    // and share its pages instead of each reading the file again.
+    auto fileBuf = xcl::map_binary_file(binaryFile);
+
     std::cout << "Now create (" << iter << ") CHILD processes" << std::endl;
     for (int i = 0; i < iter; i++) {
         if (fork() == 0) {